@@ -33,38 +33,111 @@
 
 #include <Wire.h>
 #include <limits.h>
+#include <math.h>
 
 #include "Adafruit_L3GD20_U.h"
 
-TwoWire *_i2c; ///< Global I2C interface pointer
+/** Sample period in microseconds for each 'gyroDataRate_t', on the L3GD20
+    and on the L3GD20H. The L3GD20 has no LOW_ODR rates. */
+static const uint32_t dataRatePeriodUs[2][7] = {
+    {10526, 5263, 2632, 1316, 10526, 10526, 10526},
+    {10000, 5000, 2500, 1250, 80000, 40000, 20000}};
 
-/***************************************************************************
- PRIVATE FUNCTIONS
- ***************************************************************************/
+/** millis() value at the micros() time 'us', which must be in the past. */
+static uint32_t millisAt(uint32_t us) {
+  return millis() - (micros() - us) / 1000;
+}
 
-/**************************************************************************/
-/**
-    @brief  Abstracts away platform differences in Arduino wire library
+/** Shadowed registers that can be written: CTRL_REG1..REFERENCE,
+    FIFO_CTRL_REG, INT1_CFG, TSH_XH..INT1_DURATION and LOW_ODR. Bit n
+    stands for register 0x20 + n. LOW_ODR is reserved on the L3GD20, and
+    only ever cached or written on the L3GD20H. */
+static const uint32_t shadowWritable = 0x03FD403F;
 
-    @param  reg     The register to write to.
-    @param  value   The value to assign to 'reg'.
-*/
-/**************************************************************************/
-void Adafruit_L3GD20_Unified::write8(byte reg, byte value) {
-  _i2c->beginTransmission(L3GD20_ADDRESS);
-#if ARDUINO >= 100
-  _i2c->write((uint8_t)reg);
-  _i2c->write((uint8_t)value);
-#else
-  _i2c->send(reg);
-  _i2c->send(value);
-#endif
-  _i2c->endTransmission();
+/** Clean registers a coalesced write may rewrite to join two dirty runs,
+    cheaper than addressing a new transaction. */
+static const uint8_t shadowMaxGap = 2;
+
+/** Sensitivity of a range as a multiple of the 250 dps sensitivity. */
+static int32_t rangeWeight(gyroRange_t range) {
+  switch (range) {
+  case GYRO_RANGE_2000DPS:
+    return 8;
+  case GYRO_RANGE_500DPS:
+    return 2;
+  default:
+    return 1;
+  }
+}
+
+/** The next wider range, or 'range' itself if it is the widest. */
+static gyroRange_t widerRange(gyroRange_t range) {
+  return (range == GYRO_RANGE_250DPS) ? GYRO_RANGE_500DPS : GYRO_RANGE_2000DPS;
+}
+
+/** The next narrower range, or 'range' itself if it is the narrowest. */
+static gyroRange_t narrowerRange(gyroRange_t range) {
+  return (range == GYRO_RANGE_2000DPS) ? GYRO_RANGE_500DPS : GYRO_RANGE_250DPS;
+}
+
+/** Converts a raw sample taken at range 'from' to the units of range 'to',
+    clipping at full scale. */
+static void rescaleSample(gyroRawData_t *sample, gyroRange_t from,
+                          gyroRange_t to) {
+  if (from == to) {
+    return;
+  }
+  const int32_t num = rangeWeight(from);
+  const int32_t den = rangeWeight(to);
+  int16_t *axis[3] = {&sample->x, &sample->y, &sample->z};
+  for (uint8_t i = 0; i < 3; i++) {
+    int32_t value = (int32_t)*axis[i] * num / den;
+    if (value > 32767) {
+      value = 32767;
+    } else if (value < -32768) {
+      value = -32768;
+    }
+    *axis[i] = (int16_t)value;
+  }
+}
+
+/** Appends an unsigned LEB128 varint, returns the new end. */
+static uint8_t *putVarint(uint8_t *p, uint32_t value) {
+  while (value >= 0x80) {
+    *p++ = (uint8_t)value | 0x80;
+    value >>= 7;
+  }
+  *p++ = (uint8_t)value;
+  return p;
+}
+
+/** Reads an unsigned LEB128 varint of up to 5 bytes, NULL if it runs past
+    'end'. */
+static const uint8_t *getVarint(const uint8_t *p, const uint8_t *end,
+                                uint32_t *value) {
+  uint32_t result = 0;
+
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (p == end) {
+      return NULL;
+    }
+    uint8_t b = *p++;
+    result |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      *value = result;
+      return p;
+    }
+  }
+  return NULL;
 }
 
+/***************************************************************************
+ PRIVATE FUNCTIONS
+ ***************************************************************************/
+
 /**************************************************************************/
 /**
-    @brief  Abstracts away platform differences in Arduino wire library
+    @brief  Reads a register over whichever bus the sensor is on
 
     @param  reg     The register to read.
 
@@ -72,336 +145,3516 @@ void Adafruit_L3GD20_Unified::write8(byte reg, byte value) {
 */
 /**************************************************************************/
 byte Adafruit_L3GD20_Unified::read8(byte reg) {
-  byte value;
+  uint8_t value;
 
-  _i2c->beginTransmission((byte)L3GD20_ADDRESS);
-#if ARDUINO >= 100
-  _i2c->write((uint8_t)reg);
-#else
-  _i2c->send(reg);
-#endif
-  _i2c->endTransmission();
-  _i2c->requestFrom((byte)L3GD20_ADDRESS, (byte)1);
-#if ARDUINO >= 100
-  value = _i2c->read();
-#else
-  value = _i2c->receive();
+#ifdef L3GD20_BUS_REPLAY
+  if (_replayFunc != NULL) {
+    uint8_t length = 1;
+    _replayFunc(GYRO_BUS_READ8, reg, &value, &length, _replayContext);
+    return value;
+  }
 #endif
+  const uint32_t start = _captureFunc ? micros() : 0;
+  value = _useSpi ? _spiBus.read8(reg) : _i2cBus.read8(reg);
+  capture(GYRO_BUS_READ8, reg, &value, 1, true, start);
 
   return value;
 }
 
-/***************************************************************************
- CONSTRUCTOR
- ***************************************************************************/
-
 /**************************************************************************/
 /**
-    @brief  Instantiates a new Adafruit_L3GD20_Unified class
+    @brief  Writes consecutive registers in one auto-increment transaction
 
-    @param  sensorID    The unique ID to assign to this sensor instance.
-                        This can be used to distinguish multiple similar
-                        sensors on a system, or to distinguish merged data
-                        in a logging system.
+    @param  reg     The first register to write to.
+    @param  buf     The values to write.
+    @param  len     The number of registers to write.
+
+    @return True if the sensor acknowledged, otherwise false.
 */
 /**************************************************************************/
-Adafruit_L3GD20_Unified::Adafruit_L3GD20_Unified(int32_t sensorID) {
-  _sensorID = sensorID;
-  _autoRangeEnabled = false;
-}
+bool Adafruit_L3GD20_Unified::writeBytes(byte reg, const uint8_t *buf,
+                                         uint8_t len) {
+#ifdef L3GD20_BUS_REPLAY
+  if (_replayFunc != NULL) {
+    return _replayFunc(GYRO_BUS_WRITE, reg, (uint8_t *)buf, &len,
+                       _replayContext);
+  }
+#endif
+  const uint32_t start = _captureFunc ? micros() : 0;
+  bool ok = _useSpi ? _spiBus.writeBytes(reg, buf, len)
+                    : _i2cBus.writeBytes(reg, buf, len);
+  capture(GYRO_BUS_WRITE, reg, buf, len, ok, start);
 
-/***************************************************************************
- PUBLIC FUNCTIONS
- ***************************************************************************/
+  return ok;
+}
 
 /**************************************************************************/
 /**
-    @brief  Setups the HW
+    @brief  Reads a configuration register through the shadow, only going
+            to the bus the first time
 
-    @param  rng     The 'gyroRange_t' to use when configuring the sensor.
-    @param  theWire Optional parameter for the I2C device we will use.
-                    Default is "Wire".
+    @param  reg     The register to read, 0x20..0x39.
 
-    @return True if the 'begin' process was successful, otherwise false.
+    @return The value of 'reg', including changes not flushed yet.
 */
 /**************************************************************************/
-bool Adafruit_L3GD20_Unified::begin(gyroRange_t rng, TwoWire *theWire) {
-  /* Set the I2C bus interface. */
-  _i2c = theWire;
+uint8_t Adafruit_L3GD20_Unified::readConfig(byte reg) {
+  const uint8_t index = reg - GYRO_REGISTER_CTRL_REG1;
+  const uint32_t bit = 1UL << index;
 
-  /* Enable I2C */
-  _i2c->begin();
+  if (!(_shadowValid & bit)) {
+    _shadow[index] = read8(reg);
+    _shadowValid |= bit;
+  }
+  return _shadow[index];
+}
 
-  /* Set the range the an appropriate value */
-  _range = rng;
+/**************************************************************************/
+/**
+    @brief  Stages a configuration register write for flushConfig()
 
-  /* Clear the raw sensor data */
-  raw.x = 0;
-  raw.y = 0;
-  raw.z = 0;
+    Writing the value the register already holds costs nothing.
 
-  /* Make sure we have the correct chip ID since this checks
-     for correct address and that the IC is properly connected */
-  uint8_t id = read8(GYRO_REGISTER_WHO_AM_I);
-  // Serial.println(id, HEX);
-  if ((id != L3GD20_ID) && (id != L3GD20H_ID)) {
-    return false;
+    @param  reg     The register to write to, 0x20..0x39.
+    @param  value   The value to assign to 'reg'.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::writeConfig(byte reg, uint8_t value) {
+  const uint8_t index = reg - GYRO_REGISTER_CTRL_REG1;
+  const uint32_t bit = 1UL << index;
+
+  if ((_shadowValid & bit) && (_shadow[index] == value)) {
+    return;
   }
+  _shadow[index] = value;
+  _shadowValid |= bit;
+  _shadowDirty |= bit;
+}
 
-  /* Set CTRL_REG1 (0x20)
-   ====================================================================
-   BIT  Symbol    Description                                   Default
-   ---  ------    --------------------------------------------- -------
-   7-6  DR1/0     Output data rate                                   00
-   5-4  BW1/0     Bandwidth selection                                00
-     3  PD        0 = Power-down mode, 1 = normal/sleep mode          0
-     2  ZEN       Z-axis enable (0 = disabled, 1 = enabled)           1
-     1  YEN       Y-axis enable (0 = disabled, 1 = enabled)           1
-     0  XEN       X-axis enable (0 = disabled, 1 = enabled)           1 */
+/**************************************************************************/
+/**
+    @brief  Stages a change to some bits of a configuration register
 
-  /* Reset then switch to normal mode and enable all three channels */
-  write8(GYRO_REGISTER_CTRL_REG1, 0x00);
-  write8(GYRO_REGISTER_CTRL_REG1, 0x0F);
-  /* ------------------------------------------------------------------ */
+    @param  reg     The register to modify, 0x20..0x39.
+    @param  mask    The bits to change.
+    @param  value   The new value of the bits in 'mask'.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::updateConfig(byte reg, uint8_t mask,
+                                           uint8_t value) {
+  writeConfig(reg, (readConfig(reg) & ~mask) | (value & mask));
+}
 
-  /* Set CTRL_REG2 (0x21)
-   ====================================================================
-   BIT  Symbol    Description                                   Default
-   ---  ------    --------------------------------------------- -------
-   5-4  HPM1/0    High-pass filter mode selection                    00
-   3-0  HPCF3..0  High-pass filter cutoff frequency selection      0000 */
+/**************************************************************************/
+/**
+    @brief  Writes all staged configuration changes
 
-  /* Nothing to do ... keep default values */
-  /* ------------------------------------------------------------------ */
+    Consecutive dirty registers go out as one auto-increment write. Runs
+    separated by a few clean, cached registers are joined by rewriting
+    those, which is cheaper than another transaction.
 
-  /* Set CTRL_REG3 (0x22)
-   ====================================================================
-   BIT  Symbol    Description                                   Default
-   ---  ------    --------------------------------------------- -------
-     7  I1_Int1   Interrupt enable on INT1 (0=disable,1=enable)       0
-     6  I1_Boot   Boot status on INT1 (0=disable,1=enable)            0
-     5  H-Lactive Interrupt active config on INT1 (0=high,1=low)      0
-     4  PP_OD     Push-Pull/Open-Drain (0=PP, 1=OD)                   0
-     3  I2_DRDY   Data ready on DRDY/INT2 (0=disable,1=enable)        0
-     2  I2_WTM    FIFO wtrmrk int on DRDY/INT2 (0=dsbl,1=enbl)        0
-     1  I2_ORun   FIFO overrun int on DRDY/INT2 (0=dsbl,1=enbl)       0
-     0  I2_Empty  FIFI empty int on DRDY/INT2 (0=dsbl,1=enbl)         0 */
+    @return True if every write was acknowledged, otherwise false. Failed
+            registers stay dirty and are retried on the next flush.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::flushConfig(void) {
+  bool ok = true;
+  uint8_t first = 0;
 
-  /* Nothing to do ... keep default values */
-  /* ------------------------------------------------------------------ */
+  while (first < L3GD20_SHADOW_SIZE) {
+    if (!(_shadowDirty & (1UL << first))) {
+      first++;
+      continue;
+    }
 
-  /* Set CTRL_REG4 (0x23)
-   ====================================================================
-   BIT  Symbol    Description                                   Default
-   ---  ------    --------------------------------------------- -------
-     7  BDU       Block Data Update (0=continuous, 1=LSB/MSB)         0
-     6  BLE       Big/Little-Endian (0=Data LSB, 1=Data MSB)          0
-   5-4  FS1/0     Full scale selection                               00
-                                  00 = 250 dps
-                                  01 = 500 dps
-                                  10 = 2000 dps
-                                  11 = 2000 dps
-     0  SIM       SPI Mode (0=4-wire, 1=3-wire)                       0 */
+    /* Extend the run while the registers are writable and either dirty or
+       cached clean ones that close a small gap */
+    uint8_t last = first;
+    for (uint8_t i = first + 1; i < L3GD20_SHADOW_SIZE; i++) {
+      const uint32_t bit = 1UL << i;
+      if (!(shadowWritable & bit)) {
+        break;
+      }
+      if (_shadowDirty & bit) {
+        last = i;
+      } else if (!(_shadowValid & bit) || (i - last > shadowMaxGap)) {
+        break;
+      }
+    }
 
-  /* Adjust resolution if requested */
-  switch (_range) {
-  case GYRO_RANGE_250DPS:
-    write8(GYRO_REGISTER_CTRL_REG4, 0x00);
-    break;
-  case GYRO_RANGE_500DPS:
-    write8(GYRO_REGISTER_CTRL_REG4, 0x10);
-    break;
-  case GYRO_RANGE_2000DPS:
-    write8(GYRO_REGISTER_CTRL_REG4, 0x20);
-    break;
+    const uint8_t len = last - first + 1;
+    if (writeBytes(GYRO_REGISTER_CTRL_REG1 + first, &_shadow[first], len)) {
+      _shadowDirty &= ~(((1UL << len) - 1) << first);
+    } else {
+      ok = false;
+    }
+    first = last + 1;
   }
-  /* ------------------------------------------------------------------ */
-
-  /* Set CTRL_REG5 (0x24)
-   ====================================================================
-   BIT  Symbol    Description                                   Default
-   ---  ------    --------------------------------------------- -------
-     7  BOOT      Reboot memory content (0=normal, 1=reboot)          0
-     6  FIFO_EN   FIFO enable (0=FIFO disable, 1=enable)              0
-     4  HPen      High-pass filter enable (0=disable,1=enable)        0
-   3-2  INT1_SEL  INT1 Selection config                              00
-   1-0  OUT_SEL   Out selection config                               00 */
 
-  /* Nothing to do ... keep default values */
-  /* ------------------------------------------------------------------ */
+  /* BOOT clears itself once the reboot is done */
+  _shadow[GYRO_REGISTER_CTRL_REG5 - GYRO_REGISTER_CTRL_REG1] &= ~0x80;
 
-  return true;
+  return ok;
 }
 
 /**************************************************************************/
 /**
-    @brief  Enables or disables auto-ranging
+    @brief  Sets the register pointer for a following auto-increment read
 
-    @param  enabled Set to 'true' to enable auto-ranging, 'false' to disable.
+    Over SPI the address is sent in the same frame as the data, so it is
+    only remembered here.
+
+    @param  reg     The first register to read.
+
+    @return True if the sensor acknowledged, otherwise false.
 */
 /**************************************************************************/
-void Adafruit_L3GD20_Unified::enableAutoRange(bool enabled) {
-  _autoRangeEnabled = enabled;
+bool Adafruit_L3GD20_Unified::selectRegister(byte reg) {
+  _selected = reg;
+#ifdef L3GD20_BUS_REPLAY
+  if (_replayFunc != NULL) {
+    uint8_t length = 0;
+    return _replayFunc(GYRO_BUS_SELECT, reg, NULL, &length, _replayContext);
+  }
+#endif
+  const uint32_t start = _captureFunc ? micros() : 0;
+  bool ok = _useSpi ? _spiBus.select(reg) : _i2cBus.select(reg);
+  capture(GYRO_BUS_SELECT, reg, NULL, 0, ok, start);
+
+  return ok;
 }
 
 /**************************************************************************/
 /**
-    @brief  Gets the most recent sensor event, containing a new sample
-            from the sensor.
+    @brief  Reads bytes starting at the register set by selectRegister()
 
-    @param  event   Pointer to the placeholder where the sensor event data
-                    should be written.
+    @param  buf     The placeholder where the register values are written.
+    @param  len     The number of bytes to read. Must not exceed
+                    L3GD20_I2C_BUFFER_SIZE when using I2C.
 
-    @return True if the event was successfully read, otherwise false.
+    @return True if all bytes were read, otherwise false.
 */
 /**************************************************************************/
-bool Adafruit_L3GD20_Unified::getEvent(sensors_event_t *event) {
-  bool readingValid = false;
+bool Adafruit_L3GD20_Unified::receiveBytes(uint8_t *buf, uint8_t len) {
+#ifdef L3GD20_BUS_REPLAY
+  if (_replayFunc != NULL) {
+    uint8_t length = len;
+    return _replayFunc(GYRO_BUS_RECEIVE, _selected, buf, &length,
+                       _replayContext) &&
+           (length == len);
+  }
+#endif
+  const uint32_t start = _captureFunc ? micros() : 0;
+  bool ok = _useSpi ? _spiBus.receive(buf, len) : _i2cBus.receive(buf, len);
+  capture(GYRO_BUS_RECEIVE, _selected, buf, ok ? len : 0, ok, start);
 
-  /* Clear the event */
-  memset(event, 0, sizeof(sensors_event_t));
+  return ok;
+}
 
-  /* Clear the raw data placeholder */
-  raw.x = 0;
-  raw.y = 0;
-  raw.z = 0;
+/**************************************************************************/
+/**
+    @brief  Reads a block of consecutive registers in a single auto-increment
+            transaction
 
-  event->version = sizeof(sensors_event_t);
-  event->sensor_id = _sensorID;
-  event->type = SENSOR_TYPE_GYROSCOPE;
+    @param  reg     The first register to read.
+    @param  buf     The placeholder where the register values are written.
+    @param  len     The number of bytes to read. Must not exceed
+                    L3GD20_I2C_BUFFER_SIZE when using I2C.
+
+    @return True if all bytes were read, otherwise false.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::readBytes(byte reg, uint8_t *buf, uint8_t len) {
+  return selectRegister(reg) && receiveBytes(buf, len);
+}
 
-  while (!readingValid) {
-    event->timestamp = millis();
+/**************************************************************************/
+/**
+    @brief  Drains samples from the FIFO over whichever bus the sensor is on
 
-    /* Read 6 bytes from the sensor */
-    _i2c->beginTransmission((byte)L3GD20_ADDRESS);
-#if ARDUINO >= 100
-    _i2c->write(GYRO_REGISTER_OUT_X_L | 0x80);
-#else
-    _i2c->send(GYRO_REGISTER_OUT_X_L | 0x80);
-#endif
-    if (_i2c->endTransmission() != 0) {
-      // Error. Retry.
-      continue;
-    }
-    _i2c->requestFrom((byte)L3GD20_ADDRESS, (byte)6);
+    @param  buf     The placeholder where the raw samples are written.
+    @param  count   The number of samples to read, at most the FIFO size.
 
-#if ARDUINO >= 100
-    uint8_t xlo = _i2c->read();
-    uint8_t xhi = _i2c->read();
-    uint8_t ylo = _i2c->read();
-    uint8_t yhi = _i2c->read();
-    uint8_t zlo = _i2c->read();
-    uint8_t zhi = _i2c->read();
-#else
-    uint8_t xlo = _i2c->receive();
-    uint8_t xhi = _i2c->receive();
-    uint8_t ylo = _i2c->receive();
-    uint8_t yhi = _i2c->receive();
-    uint8_t zlo = _i2c->receive();
-    uint8_t zhi = _i2c->receive();
+    @return The number of samples read.
+*/
+/**************************************************************************/
+size_t Adafruit_L3GD20_Unified::drainBus(gyroRawData_t *buf, size_t count) {
+#ifdef L3GD20_BUS_REPLAY
+  if (_replayFunc != NULL) {
+    uint8_t b[6 * L3GD20_FIFO_SIZE];
+    uint8_t length = 6 * count;
+    _replayFunc(GYRO_BUS_DRAIN, GYRO_REGISTER_OUT_X_L, b, &length,
+                _replayContext);
+    l3gd20Decode(b, buf, length / 6);
+    return length / 6;
+  }
 #endif
+  const uint32_t start = _captureFunc ? micros() : 0;
+  size_t done = _useSpi ? l3gd20DrainFifo(_spiBus, buf, count)
+                        : l3gd20DrainFifo(_i2cBus, buf, count);
+  capture(GYRO_BUS_DRAIN, GYRO_REGISTER_OUT_X_L, buf, 6 * done,
+          done == count, start);
 
-    /* Shift values to create properly formed integer (low byte first) */
-    event->gyro.x = (int16_t)(xlo | (xhi << 8));
-    event->gyro.y = (int16_t)(ylo | (yhi << 8));
-    event->gyro.z = (int16_t)(zlo | (zhi << 8));
+  return done;
+}
 
-    /* Assign raw values in case someone needs them */
-    raw.x = (int16_t)(xlo | (xhi << 8));
-    raw.y = (int16_t)(ylo | (yhi << 8));
-    raw.z = (int16_t)(zlo | (zhi << 8));
+/**************************************************************************/
+/**
+    @brief  Hands a record of a finished bus transaction to the capture
+            function, if one is set, as the header and then the payload
+
+    @param  op      The kind of transaction.
+    @param  reg     The register addressed.
+    @param  data    The bytes read or written, or for GYRO_BUS_DRAIN the
+                    raw samples.
+    @param  length  The number of bytes in 'data'.
+    @param  ok      False if the bus failed.
+    @param  start   The micros() time the transaction started.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::capture(gyroBusOp_t op, uint8_t reg,
+                                      const void *data, uint8_t length,
+                                      bool ok, uint32_t start) {
+  if (_captureFunc == NULL) {
+    return;
+  }
 
-    /* Make sure the sensor isn't saturating if auto-ranging is enabled */
-    if (!_autoRangeEnabled) {
-      readingValid = true;
-    } else {
-      /* Check if the sensor is saturating or not */
-      if ((event->gyro.x >= 32760) | (event->gyro.x <= -32760) |
-          (event->gyro.y >= 32760) | (event->gyro.y <= -32760) |
-          (event->gyro.z >= 32760) | (event->gyro.z <= -32760)) {
-        /* Saturating .... increase the range if we can */
-        switch (_range) {
-        case GYRO_RANGE_500DPS:
-          /* Push the range up to 2000dps */
-          _range = GYRO_RANGE_2000DPS;
-          write8(GYRO_REGISTER_CTRL_REG1, 0x00);
-          write8(GYRO_REGISTER_CTRL_REG1, 0x0F);
-          write8(GYRO_REGISTER_CTRL_REG4, 0x20);
-          write8(GYRO_REGISTER_CTRL_REG5, 0x80);
-          readingValid = false;
-          // Serial.println("Changing range to 2000DPS");
-          break;
-        case GYRO_RANGE_250DPS:
-          /* Push the range up to 500dps */
-          _range = GYRO_RANGE_500DPS;
-          write8(GYRO_REGISTER_CTRL_REG1, 0x00);
-          write8(GYRO_REGISTER_CTRL_REG1, 0x0F);
-          write8(GYRO_REGISTER_CTRL_REG4, 0x10);
-          write8(GYRO_REGISTER_CTRL_REG5, 0x80);
-          readingValid = false;
-          // Serial.println("Changing range to 500DPS");
-          break;
-        default:
-          readingValid = true;
-          break;
-        }
-      } else {
-        /* All values are withing range */
-        readingValid = true;
+  /* Only the header is assembled here; the payload goes to the capture
+     function straight from 'data', a sample at a time for drains */
+  uint8_t header[13];
+  uint32_t end = micros();
+  uint8_t *p = header;
+
+  *p++ = op | (ok ? 0x00 : 0x80);
+  p = putVarint(p, start - _captureEnd);
+  p = putVarint(p, end - start);
+  *p++ = reg;
+  *p++ = length;
+  _captureEnd = end;
+  _captureFunc(header, p - header, _captureContext);
+
+  if (op == GYRO_BUS_DRAIN) {
+    /* Back to register order, independent of the MCU's byte order */
+    const gyroRawData_t *sample = (const gyroRawData_t *)data;
+    for (uint8_t i = 0; i < length / 6; i++) {
+      const int16_t axis[3] = {sample[i].x, sample[i].y, sample[i].z};
+      uint8_t bytes[6];
+      for (uint8_t a = 0; a < 3; a++) {
+        bytes[2 * a] = (uint8_t)axis[a];
+        bytes[2 * a + 1] = (uint8_t)((uint16_t)axis[a] >> 8);
       }
+      _captureFunc(bytes, sizeof(bytes), _captureContext);
     }
+  } else if (length > 0) {
+    _captureFunc((const uint8_t *)data, length, _captureContext);
   }
+}
 
-  /* Compensate values depending on the resolution */
-  switch (_range) {
-  case GYRO_RANGE_250DPS:
-    event->gyro.x *= GYRO_SENSITIVITY_250DPS;
-    event->gyro.y *= GYRO_SENSITIVITY_250DPS;
-    event->gyro.z *= GYRO_SENSITIVITY_250DPS;
-    break;
-  case GYRO_RANGE_500DPS:
-    event->gyro.x *= GYRO_SENSITIVITY_500DPS;
-    event->gyro.y *= GYRO_SENSITIVITY_500DPS;
-    event->gyro.z *= GYRO_SENSITIVITY_500DPS;
-    break;
-  case GYRO_RANGE_2000DPS:
-    event->gyro.x *= GYRO_SENSITIVITY_2000DPS;
-    event->gyro.y *= GYRO_SENSITIVITY_2000DPS;
-    event->gyro.z *= GYRO_SENSITIVITY_2000DPS;
-    break;
-  }
+/**************************************************************************/
+/**
+    @brief  Reads a new sample into 'raw', retrying on bus errors
 
-  /* Convert values to rad/s */
-  event->gyro.x *= SENSORS_DPS_TO_RADS;
-  event->gyro.y *= SENSORS_DPS_TO_RADS;
-  event->gyro.z *= SENSORS_DPS_TO_RADS;
+    @return True if a sample was read, otherwise false.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::readSample(void) {
+  uint8_t attempts = 0;
+  gyroRawData_t sample;
+  gyroReadStatus_t status;
+
+  /* Give up rather than hang if the bus keeps failing */
+  while ((status = readOutput(&sample)) == GYRO_READ_ERROR) {
+    if (++attempts == L3GD20_POLL_TIMEOUT) {
+      return false;
+    }
+  }
+  if (status != GYRO_READ_DONE) {
+    /* Nothing new, 'raw' keeps the last sample */
+    return false;
+  }
+  raw = sample;
 
   return true;
 }
 
 /**************************************************************************/
 /**
-    @brief  Gets the sensor_t data, describing the features of this sensor.
+    @brief  Reads the output registers once, at the current range
 
-    @param  sensor  The plaxceholder where the 'sensor_t' data should be
-                    written.
+    The burst starts early enough to include STATUS_REG right after a range
+    change, to tell whether the output registers were refreshed since, and
+    OUT_TEMP too with status reads enabled.
+
+    @param  sample  The placeholder where the raw sample is written.
+
+    @return GYRO_READ_DONE if the sample was read, GYRO_READ_STALE if a
+            status read found no new sample or the sensor is not measuring
+            or still settling, GYRO_READ_ERROR if the bus failed.
 */
 /**************************************************************************/
-void Adafruit_L3GD20_Unified::getSensor(sensor_t *sensor) {
-  /* Clear the sensor_t object */
-  memset(sensor, 0, sizeof(sensor_t));
+gyroReadStatus_t Adafruit_L3GD20_Unified::readOutput(gyroRawData_t *sample) {
+  uint8_t b[8];
+  const uint8_t skip = _statusRead ? 2 : (_rangeSettling ? 1 : 0);
+  uint8_t length;
+  const uint8_t from = outputWindow(skip, &length);
+  uint32_t start = micros();
+
+  /* Nothing is measured in sleep and power-down mode */
+  if (_powerMode != GYRO_POWER_NORMAL) {
+    return GYRO_READ_STALE;
+  }
+  if (!readBytes(from, b, length)) {
+    return GYRO_READ_ERROR;
+  }
+  if (_statusRead && !parseStatus(b)) {
+    return GYRO_READ_STALE;
+  }
+  syncOutput(start + (micros() - start) / 2);
+  if (!settled(timestamp)) {
+    return GYRO_READ_STALE;
+  }
+  decodeOutput(b, from, sample);
+  autoRange(sample, 1, staleOutput(skip ? b[skip - 1] : 0));
+  trackBias(sample, 1);
+
+  return GYRO_READ_DONE;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the smallest register window holding the enabled axes
+
+    @param  skip    The registers to include before OUT_X_L: 1 for
+                    STATUS_REG, 2 for OUT_TEMP and STATUS_REG.
+    @param  length  The placeholder for the window length in bytes.
+
+    @return The first register of the window.
+*/
+/**************************************************************************/
+uint8_t Adafruit_L3GD20_Unified::outputWindow(uint8_t skip, uint8_t *length) {
+  uint8_t first = 0;
+  uint8_t last = 2;
+
+  while (!(_axes & (1 << first))) {
+    first++;
+  }
+  /* With the FIFO on, reading OUT_Z_H is what moves to the next entry */
+  while ((_fifoMode == GYRO_FIFO_BYPASS) && !(_axes & (1 << last))) {
+    last--;
+  }
+  const uint8_t from = skip ? GYRO_REGISTER_OUT_X_L - skip
+                            : GYRO_REGISTER_OUT_X_L + 2 * first;
+
+  *length = GYRO_REGISTER_OUT_X_L + 2 * (last + 1) - from;
+  return from;
+}
+
+/**************************************************************************/
+/**
+    @brief  Decodes the enabled axes from a window read with outputWindow()
+
+    @param  b       The register values of the window.
+    @param  from    The first register of the window.
+    @param  sample  The placeholder for the sample; disabled axes read 0.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::decodeOutput(const uint8_t *b, uint8_t from,
+                                           gyroRawData_t *sample) {
+  int16_t *axis[3] = {&sample->x, &sample->y, &sample->z};
+
+  for (uint8_t i = 0; i < 3; i++) {
+    if (_axes & (1 << i)) {
+      /* Shift values to create properly formed integer (low byte first) */
+      const uint8_t *v = &b[GYRO_REGISTER_OUT_X_L + 2 * i - from];
+      *axis[i] = (int16_t)(v[0] | (v[1] << 8));
+    } else {
+      *axis[i] = 0;
+    }
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Clears the disabled axes of samples read with all three, e.g.
+            from the FIFO
+
+    @param  buf     The samples.
+    @param  count   The number of samples.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::maskAxes(gyroRawData_t *buf, size_t count) {
+  if (_axes == GYRO_AXIS_ALL) {
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (!(_axes & GYRO_AXIS_X)) {
+      buf[i].x = 0;
+    }
+    if (!(_axes & GYRO_AXIS_Y)) {
+      buf[i].y = 0;
+    }
+    if (!(_axes & GYRO_AXIS_Z)) {
+      buf[i].z = 0;
+    }
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Takes in OUT_TEMP and STATUS_REG from a status read
+
+    @param  b   OUT_TEMP followed by STATUS_REG.
+
+    @return True if the output registers hold a new sample, otherwise
+            false. Always true with the FIFO on, which has its own level.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::parseStatus(const uint8_t *b) {
+  /* Read STATUS_REG (0x27)
+   ====================================================================
+   BIT  Symbol    Description
+   ---  ------    ---------------------------------------------
+     7  ZYXOR     A new sample overwrote one that was not read
+   6-4  xOR       Per axis overrun
+     3  ZYXDA     A new sample is available
+   2-0  xDA       Per axis new data */
+  temperature = (int8_t)b[0];
+
+  if (_fifoMode != GYRO_FIFO_BYPASS) {
+    return true;
+  }
+  if (b[1] & 0x80) {
+    overruns++;
+  }
+  return (b[1] & 0x08) != 0;
+}
+
+/**************************************************************************/
+/**
+    @brief  Counts whether a sample just read from the output registers
+            was taken before the last range change
+
+    @param  status  STATUS_REG read together with the sample, if the
+                    output registers were still settling.
+
+    @return 1 if the sample predates the range change, otherwise 0.
+*/
+/**************************************************************************/
+size_t Adafruit_L3GD20_Unified::staleOutput(uint8_t status) {
+  if (_fifoMode != GYRO_FIFO_BYPASS) {
+    /* The output registers show the oldest FIFO entry */
+    return staleFifo(1);
+  }
+  if (!_rangeSettling) {
+    return 0;
+  }
+  if (status & 0x08) {
+    /* ZYXDA: a new sample arrived since the change */
+    _rangeSettling = false;
+    return 0;
+  }
+  return 1;
+}
+
+/**************************************************************************/
+/**
+    @brief  Counts how many samples just drained from the FIFO were taken
+            before the last range change
+
+    @param  count   The number of samples drained, oldest first.
+
+    @return The number of leading samples at the previous range.
+*/
+/**************************************************************************/
+size_t Adafruit_L3GD20_Unified::staleFifo(size_t count) {
+  if (count > _staleSamples) {
+    count = _staleSamples;
+  }
+  _staleSamples -= count;
+  return count;
+}
+
+/**************************************************************************/
+/**
+    @brief  Checks whether any axis of a raw sample is at full scale
+
+    @param  sample  The raw sample to check.
+
+    @return True if the sample is saturating, otherwise false.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::isSaturated(const gyroRawData_t &sample) {
+  return (sample.x >= 32760) || (sample.x <= -32760) ||
+         (sample.y >= 32760) || (sample.y <= -32760) ||
+         (sample.z >= 32760) || (sample.z <= -32760);
+}
+
+/**************************************************************************/
+/**
+    @brief  Runs the auto-range engine over freshly read samples and
+            rescales them all to the current range
+
+    A saturated sample widens the range. The range steps down once the
+    set number of consecutive samples stayed below the set percentage of
+    the narrower range, but never below the range passed to begin().
+    Samples that were already read keep their own range; a saturated one
+    is returned clipped rather than read again. A step down waits for a
+    batch that is quiet throughout and for rangeDrained(), so no sample
+    taken at the wider range is ever squeezed into the narrower one.
+
+    @param  buf     The samples, oldest first.
+    @param  count   The number of samples in 'buf'.
+    @param  stale   The number of leading samples taken at the range in
+                    effect before the last change.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::autoRange(gyroRawData_t *buf, size_t count,
+                                        size_t stale) {
+  const gyroRange_t previous = _staleRange;
+  const gyroRange_t measured = _range;
+
+  if (_autoRangeEnabled && !_staleSamples && !_rangeSettling &&
+      !__atomic_load_n(&_ringStale, __ATOMIC_ACQUIRE)) {
+    gyroRange_t next = measured;
+    int32_t quiet = 0;
+    if (measured != _rangeFloor) {
+      quiet = (int32_t)32767 * rangeWeight(narrowerRange(measured)) /
+              rangeWeight(measured) * _rangeDownPercent / 100;
+    }
+
+    bool calm = (stale == 0);
+    for (size_t i = stale; i < count; i++) {
+      const gyroRawData_t &s = buf[i];
+      if (isSaturated(s)) {
+        next = widerRange(measured);
+        break;
+      }
+      if ((s.x < quiet) && (s.x > -quiet) && (s.y < quiet) &&
+          (s.y > -quiet) && (s.z < quiet) && (s.z > -quiet)) {
+        if (_rangeCalm < _rangeDownSamples) {
+          _rangeCalm++;
+        }
+      } else {
+        _rangeCalm = 0;
+        calm = false;
+      }
+    }
+    /* The whole batch is rescaled below, so it must fit the narrower
+       range; if the step has to wait, the next batch tries again */
+    if ((next == measured) && quiet && calm &&
+        (_rangeCalm >= _rangeDownSamples) && rangeDrained()) {
+      next = narrowerRange(measured);
+    }
+    if (next != measured) {
+      changeRange(next);
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    rescaleSample(&buf[i], (i < stale) ? previous : measured, _range);
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Tells whether every sample taken so far has been handed out
+
+    Costs a FIFO_SRC_REG read with the FIFO on. Samples still waiting in
+    the FIFO or the sample buffer would have to be rescaled after a range
+    change.
+
+    @return True if neither the FIFO nor the sample buffer holds samples.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::rangeDrained(void) {
+  /* Includes the part of a wrapped drain not published yet */
+  if ((available() > 0) || (_ringPending > 0)) {
+    return false;
+  }
+  return (_fifoMode == GYRO_FIFO_BYPASS) || (getFifoLevel() == 0);
+}
+
+/**************************************************************************/
+/**
+    @brief  Switches the measurement range without interrupting sampling
+
+    Only the FS bits of CTRL_REG4 are rewritten. The sensor keeps running
+    and no trimming reload is needed, so the next sample is already taken
+    at the new range. The samples still waiting at the old range are
+    recorded, so they can be rescaled when read.
+
+    @param  rng     The new measurement range.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::changeRange(gyroRange_t rng) {
+  _staleRange = _range;
+  _range = rng;
+  _rangeCalm = 0;
+
+  updateConfig(GYRO_REGISTER_CTRL_REG4, 0x30, l3gd20RangeBits(rng));
+  if (_motionEnabled) {
+    /* Keep the INT1 thresholds at the same rates */
+    writeMotionThresholds();
+  }
+  flushConfig();
+
+  /* Everything in the FIFO now predates the change. A sample taken during
+     the level read itself is counted too, the lesser error. */
+  if (_fifoMode != GYRO_FIFO_BYPASS) {
+    _staleSamples = getFifoLevel();
+  } else {
+    _rangeSettling = true;
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Stages the INT1 thresholds in LSB of the current range
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::writeMotionThresholds(void) {
+  /* Quarter mdps per LSB: 8.75 = 35/4, 17.5 = 70/4, 70 = 280/4 */
+  const int32_t mul = 35 * rangeWeight(_range);
+  const int32_t mdps[3] = {_motionThreshold.x, _motionThreshold.y,
+                           _motionThreshold.z};
+
+  /* Set TSH_XH..TSH_ZL (0x32..0x37)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+     7  -         Reserved (TSH_xH), THSx7 (TSH_xL)                   0
+   6-0  THSx14..  Threshold of axis x, 15 bit unsigned         0000000 */
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    int32_t lsb = (mdps[axis] * 4 + mul / 2) / mul;
+    if (lsb < 0) {
+      lsb = 0;
+    } else if (lsb > 0x7FFF) {
+      lsb = 0x7FFF;
+    }
+    writeConfig(GYRO_REGISTER_TSH_XH + 2 * axis, lsb >> 8);
+    writeConfig(GYRO_REGISTER_TSH_XL + 2 * axis, lsb & 0xFF);
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Converts the last raw sample to rad/s and stores it in an event
+
+    @param  event   The event whose 'gyro' vector is written.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::scaleEvent(sensors_event_t *event) {
+  const float scale = getScale();
+  float offset[3];
+
+  getBias(offset);
+  event->gyro.x = raw.x * scale - offset[0];
+  event->gyro.y = raw.y * scale - offset[1];
+  event->gyro.z = raw.z * scale - offset[2];
+}
+
+/**************************************************************************/
+/**
+    @brief  Feeds samples to the bias estimator
+
+    A still period ends at the first sample that is further than
+    L3GD20_STILL_THRESHOLD from the period's running mean. Every
+    L3GD20_STILL_SAMPLES samples of a still period make one estimate.
+
+    @param  buf     The samples, at the current range.
+    @param  count   The number of samples in 'buf'.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::trackBias(const gyroRawData_t *buf,
+                                        size_t count) {
+  if (!_biasLearning) {
+    return;
+  }
+
+  const float weight = rangeWeight(_range);
+  const float threshold =
+      L3GD20_STILL_THRESHOLD / (1000.0F * GYRO_SENSITIVITY_250DPS);
+
+  for (size_t i = 0; i < count; i++) {
+    const float v[3] = {buf[i].x * weight, buf[i].y * weight,
+                        buf[i].z * weight};
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      if (fabsf(v[axis] - _stillMean[axis]) > threshold) {
+        /* Moved, this sample starts a new still period */
+        _stillCount = 0;
+      }
+    }
+
+    if (_stillCount++ == 0) {
+      for (uint8_t axis = 0; axis < 3; axis++) {
+        _stillMean[axis] = v[axis];
+        _stillM2[axis] = 0;
+      }
+      continue;
+    }
+
+    /* Welford's update, one division per sample */
+    const float inverse = 1.0F / _stillCount;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      float delta = v[axis] - _stillMean[axis];
+      _stillMean[axis] += delta * inverse;
+      _stillM2[axis] += delta * (v[axis] - _stillMean[axis]);
+    }
+
+    if (_stillCount == L3GD20_STILL_SAMPLES) {
+      storeBias();
+      _stillCount = 0;
+    }
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Stores the mean of a complete still period in the bias table
+
+    The estimate goes to the bin of the current 'temperature'. It is
+    rejected if the period was too noisy or the mean too large to be a
+    bias, e.g. during a slow steady turn.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::storeBias(void) {
+  const float limit = L3GD20_BIAS_LIMIT / (1000.0F * GYRO_SENSITIVITY_250DPS);
+  /* Standard deviation below a quarter of the stillness threshold */
+  const float deviation =
+      L3GD20_STILL_THRESHOLD / (4000.0F * GYRO_SENSITIVITY_250DPS);
+  const float maxM2 = deviation * deviation * (L3GD20_STILL_SAMPLES - 1);
+
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    if ((fabsf(_stillMean[axis]) > limit) || (_stillM2[axis] > maxM2)) {
+      return;
+    }
+  }
+
+  if (_biasTable.valid == 0) {
+    /* Centre the middle bin on the temperature of the first estimate */
+    int16_t base = temperature - L3GD20_BIAS_BIN_WIDTH / 2 -
+                   (L3GD20_BIAS_BINS / 2) * L3GD20_BIAS_BIN_WIDTH;
+    _biasTable.baseTemperature = (base < -128) ? -128 : base;
+  }
+
+  int16_t bin = temperature - _biasTable.baseTemperature;
+  bin = (bin < 0) ? 0 : bin / L3GD20_BIAS_BIN_WIDTH;
+  if (bin >= L3GD20_BIAS_BINS) {
+    bin = L3GD20_BIAS_BINS - 1;
+  }
+
+  int16_t *bias = _biasTable.bias[bin];
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    int16_t estimate = (int16_t)lroundf(_stillMean[axis] * 16);
+    if (_biasTable.valid & (1 << bin)) {
+      /* Follow slow changes, e.g. ageing, without jumping on one estimate */
+      bias[axis] += (estimate - bias[axis]) / 4;
+    } else {
+      bias[axis] = estimate;
+    }
+  }
+  _biasTable.valid |= 1 << bin;
+}
+
+/**************************************************************************/
+/**
+    @brief  Looks up the bias at the current 'temperature'
+
+    Interpolates linearly between the centres of the nearest bins holding
+    an estimate, and holds the outermost estimate beyond them.
+
+    @param  bias    The placeholder for the bias of each axis, in 1/16 LSB
+                    at 250 dps.
+
+    @return True if there is a bias to subtract, otherwise false.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::currentBias(int32_t *bias) {
+  if (!_biasEnabled || (_biasTable.valid == 0)) {
+    return false;
+  }
+
+  /* Position in 1/16 bins, with bin n centred at 16 * n */
+  int16_t offset = temperature - _biasTable.baseTemperature;
+  int16_t pos = offset * 16 / L3GD20_BIAS_BIN_WIDTH - 8;
+  int8_t lo = -1;
+  int8_t hi = -1;
+
+  for (int8_t n = 0; n < L3GD20_BIAS_BINS; n++) {
+    if (!(_biasTable.valid & (1 << n))) {
+      continue;
+    }
+    if (n * 16 <= pos) {
+      lo = n;
+    }
+    if ((n * 16 >= pos) && (hi < 0)) {
+      hi = n;
+    }
+  }
+  if (lo < 0) {
+    lo = hi;
+  } else if (hi < 0) {
+    hi = lo;
+  }
+
+  const int16_t *a = _biasTable.bias[lo];
+  const int16_t *b = _biasTable.bias[hi];
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    if (!(_axes & (1 << axis))) {
+      /* Disabled axes read 0 and stay 0 */
+      bias[axis] = 0;
+      continue;
+    }
+    bias[axis] = a[axis];
+    if (hi != lo) {
+      bias[axis] += (int32_t)(b[axis] - a[axis]) * (pos - lo * 16) /
+                    ((hi - lo) * 16);
+    }
+  }
+
+  return true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Reads a known number of samples from the FIFO
+
+    Over I2C each burst is limited to the Wire receive buffer. Over SPI the
+    whole drain is a single chip-select frame, clocked out in chunks.
+
+    @param  buf     The placeholder where the raw samples are written.
+    @param  count       The number of samples to read. Must not exceed
+                        the FIFO level returned by syncFifo().
+    @param  timestamps  Optional placeholder for the micros() time of each
+                        sample, or NULL.
+
+    @return The number of samples written to 'buf'. Samples taken while
+            settling after a wake are read but not written.
+*/
+/**************************************************************************/
+size_t Adafruit_L3GD20_Unified::drainFifo(gyroRawData_t *buf, size_t count,
+                                          uint32_t *timestamps) {
+  size_t done = drainBus(buf, count);
+  size_t skip = 0;
+
+  /* Drop the samples taken while settling after a wake */
+  while ((skip < done) && !settled(sampleTime(skip))) {
+    skip++;
+  }
+  if (skip > 0) {
+    memmove(buf, buf + skip, (done - skip) * sizeof(*buf));
+  }
+  const size_t kept = done - skip;
+  const size_t stale = staleFifo(done);
+
+  /* FIFO entries always hold all three axes */
+  maskAxes(buf, kept);
+  autoRange(buf, kept, (stale > skip) ? stale - skip : 0);
+  trackBias(buf, kept);
+
+  if (timestamps != NULL) {
+    for (size_t i = 0; i < kept; i++) {
+      timestamps[i] = sampleTime(skip + i);
+    }
+  }
+
+  /* Assign the newest raw values in case someone needs them */
+  if (kept > 0) {
+    raw = buf[kept - 1];
+    timestamp = sampleTime(done - 1);
+  }
+  advanceClock(done);
+
+  return kept;
+}
+
+/**************************************************************************/
+/**
+    @brief  Reads the FIFO level and corrects the sample clock with it
+
+    A watermark interrupt recorded by markInterrupt() since the last call
+    gives the time of the sample that reached the watermark. Without one,
+    the level itself says the newest sample arrived before the read and the
+    next one after it; the clock is moved just enough to agree.
+
+    @return The number of samples waiting in the FIFO (0..32).
+*/
+/**************************************************************************/
+uint8_t Adafruit_L3GD20_Unified::syncFifo(void) {
+  uint32_t start = micros();
+  uint8_t level = getFifoLevel();
+  uint32_t now = start + (micros() - start) / 2;
+  uint8_t watermark = readConfig(GYRO_REGISTER_FIFO_CTRL_REG) & 0x1F;
+  int32_t period = _clockPeriod >> 8;
+
+  /* FIFO drains don't pass OUT_TEMP, but the temperature moves slowly */
+  if (_statusRead &&
+      ((millis() - _temperatureTime) >= L3GD20_TEMP_INTERVAL_MS)) {
+    uint8_t b;
+    if (readBytes(GYRO_REGISTER_OUT_TEMP, &b, 1)) {
+      temperature = (int8_t)b;
+      _temperatureTime = millis();
+    }
+  }
+
+  bool irq = __atomic_load_n(&_irqPending, __ATOMIC_ACQUIRE);
+  uint32_t irqTime = _irqTime;
+  __atomic_store_n(&_irqPending, false, __ATOMIC_RELAXED);
+
+  if (irq && (readConfig(GYRO_REGISTER_CTRL_REG3) & 0x04) &&
+      (watermark > 0) && (level >= watermark) &&
+      (level < L3GD20_FIFO_SIZE) && ((int32_t)(irqTime - _clockSync) > 0)) {
+    /* The interrupt fired as sample 'watermark - 1' arrived */
+    int32_t error = (int32_t)(irqTime - sampleTime(watermark - 1));
+    if ((error > -period) && (error < period)) {
+      correctClock(error, watermark - 1, 1, 2);
+    } else {
+      lockClock(irqTime, watermark - 1);
+    }
+  } else if (level > 0) {
+    int32_t early = (int32_t)(sampleTime(level - 1) - now);
+    int32_t late = (int32_t)(now - sampleTime(level));
+    if ((level == L3GD20_FIFO_SIZE) || (early > period) || (late > period)) {
+      /* Samples may have been lost, start over from the newest one */
+      lockClock(now - period / 2, level - 1);
+    } else if (early > 0) {
+      correctClock(-early, level - 1, 0, 3);
+    } else if (late >= 0) {
+      correctClock(late + 1, level, 0, 3);
+    }
+  }
+  _clockSync = now;
+
+  return level;
+}
+
+/**************************************************************************/
+/**
+    @brief  Stamps a sample just read from the output registers
+
+    With the FIFO on, the sample is the oldest one in it. Otherwise it is
+    the newest one taken before 'now'; a data-ready interrupt recorded by
+    markInterrupt() corrects the clock first.
+
+    @param  now The micros() time of the read.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::syncOutput(uint32_t now) {
+  if (_fifoMode != GYRO_FIFO_BYPASS) {
+    timestamp = sampleTime(0);
+    advanceClock(1);
+    return;
+  }
+
+  if (__atomic_load_n(&_irqPending, __ATOMIC_ACQUIRE)) {
+    uint32_t irqTime = _irqTime;
+    __atomic_store_n(&_irqPending, false, __ATOMIC_RELAXED);
+    if (readConfig(GYRO_REGISTER_CTRL_REG3) & 0x08) {
+      /* Sample 1 becomes the one nearest to the interrupt */
+      seekClock(irqTime - (_clockPeriod >> 9));
+      correctClock((int32_t)(irqTime - sampleTime(1)), 1, 1, 2);
+    }
+  }
+
+  seekClock(now);
+  timestamp = sampleTime(0);
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the time a sample was taken
+
+    @param  n   The sample, counted from sample 0 of the clock.
+
+    @return The micros() time of the sample.
+*/
+/**************************************************************************/
+uint32_t Adafruit_L3GD20_Unified::sampleTime(uint8_t n) {
+  return _clockBase + ((_clockFrac + n * _clockPeriod) >> 8);
+}
+
+/**************************************************************************/
+/**
+    @brief  Moves sample 0 of the clock
+
+    @param  n   The number of samples to move by, negative to go back.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::advanceClock(int32_t n) {
+  int64_t total = (int64_t)n * _clockPeriod + _clockFrac;
+
+  _clockBase += (int32_t)(total >> 8);
+  _clockFrac = (uint8_t)total;
+  _clockSpan += n;
+}
+
+/**************************************************************************/
+/**
+    @brief  Makes sample 0 of the clock the last sample taken at or before
+            a time
+
+    @param  t   The micros() time.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::seekClock(uint32_t t) {
+  int32_t elapsed = (int32_t)(t - _clockBase);
+
+  advanceClock((int32_t)(((int64_t)elapsed << 8) / (int32_t)_clockPeriod));
+  while ((int32_t)(t - sampleTime(0)) < 0) {
+    advanceClock(-1);
+  }
+  while ((int32_t)(t - sampleTime(1)) >= 0) {
+    advanceClock(1);
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Sets the clock from a sample with a known time
+
+    @param  t   The micros() time sample 'n' was taken.
+    @param  n   The sample, counted from sample 0 of the clock.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::lockClock(uint32_t t, uint8_t n) {
+  _clockBase = t;
+  _clockFrac = 0;
+  advanceClock(-(int32_t)n);
+  _clockSpan = -(int32_t)n;
+}
+
+/**************************************************************************/
+/**
+    @brief  Corrects the clock by the error measured on one sample
+
+    The phase takes a share of the error; the period takes a share of the
+    error spread over the samples since the last correction, which tracks
+    the sensor oscillator against micros().
+
+    @param  error       Measured minus predicted time of sample 'n', in
+                        microseconds.
+    @param  n           The sample, counted from sample 0 of the clock.
+    @param  phaseShift  The phase moves by error / 2^phaseShift.
+    @param  periodShift The period moves by error / span / 2^periodShift.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::correctClock(int32_t error, uint8_t n,
+                                           uint8_t phaseShift,
+                                           uint8_t periodShift) {
+  int32_t span = _clockSpan + n;
+  int32_t nominal = (int32_t)nominalPeriod() << 8;
+
+  _clockBase += error / (1 << phaseShift);
+  if (span > 0) {
+    int32_t period = (int32_t)_clockPeriod;
+    period += (error * 256 / span) / (1 << periodShift);
+    /* Stay within 12.5% of the nominal rate */
+    if (period > nominal + nominal / 8) {
+      period = nominal + nominal / 8;
+    } else if (period < nominal - nominal / 8) {
+      period = nominal - nominal / 8;
+    }
+    _clockPeriod = period;
+  }
+  _clockSpan = -(int32_t)n;
+}
+
+/**************************************************************************/
+/**
+    @brief  Restarts the clock at the nominal period, with sample 0 the
+            first sample after now
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::restartClock(void) {
+  _clockPeriod = (uint32_t)nominalPeriod() << 8;
+  lockClock(micros() + nominalPeriod(), 0);
+  _clockSync = micros();
+  __atomic_store_n(&_irqPending, false, __ATOMIC_RELAXED);
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the sample period of the data rate on the detected chip
+
+    @return The nominal period in microseconds.
+*/
+/**************************************************************************/
+uint32_t Adafruit_L3GD20_Unified::nominalPeriod(void) {
+  return dataRatePeriodUs[_variant == GYRO_VARIANT_L3GD20H][_dataRate];
+}
+
+/**************************************************************************/
+/**
+    @brief  Tells whether a sample was taken after the wake latency
+
+    @param  t   The micros() time of the sample.
+
+    @return False for samples to discard while settling after a wake.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::settled(uint32_t t) {
+  if (!_settling) {
+    return true;
+  }
+  if ((int32_t)(t - _settleUntil) < 0) {
+    return false;
+  }
+  _settling = false;
+  return true;
+}
+
+/***************************************************************************
+ CONSTRUCTOR
+ ***************************************************************************/
+
+/**************************************************************************/
+/**
+    @brief  Instantiates a new Adafruit_L3GD20_Unified class
+
+    @param  sensorID    The unique ID to assign to this sensor instance.
+                        This can be used to distinguish multiple similar
+                        sensors on a system, or to distinguish merged data
+                        in a logging system.
+*/
+/**************************************************************************/
+Adafruit_L3GD20_Unified::Adafruit_L3GD20_Unified(int32_t sensorID) {
+  init(sensorID);
+}
+
+/**************************************************************************/
+/**
+    @brief  Instantiates a new Adafruit_L3GD20_Unified class using hardware
+            SPI
+
+    @param  cs          The chip select pin.
+    @param  theSPI      The SPI bus the sensor is connected to, e.g. &SPI.
+    @param  sensorID    The unique ID to assign to this sensor instance.
+*/
+/**************************************************************************/
+Adafruit_L3GD20_Unified::Adafruit_L3GD20_Unified(int8_t cs, SPIClass *theSPI,
+                                                 int32_t sensorID) {
+  init(sensorID);
+  _spiBus = Adafruit_L3GD20_SPI(cs, theSPI);
+  _useSpi = true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Sets every member to its power-on default
+
+    @param  sensorID    The unique ID to assign to this sensor instance.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::init(int32_t sensorID) {
+  _sensorID = sensorID;
+  _useSpi = false;
+  _autoRangeEnabled = false;
+  _statusRead = false;
+  _initialized = false;
+  _variant = GYRO_VARIANT_L3GD20;
+  _dataRate = GYRO_DATARATE_95HZ;
+  _bandwidth = GYRO_BANDWIDTH_0;
+  _axes = GYRO_AXIS_ALL;
+  _highPassMode = GYRO_HIGHPASS_NORMAL_RESET;
+  _highPassCutoff = GYRO_HIGHPASS_CUTOFF_0;
+  _filterPath = GYRO_FILTER_LPF1;
+  _reference = 0;
+  _fifoMode = GYRO_FIFO_BYPASS;
+  memset(&_motionThreshold, 0, sizeof(_motionThreshold));
+  _motionEnabled = false;
+  _powerMode = GYRO_POWER_NORMAL;
+  _wakeFrom = GYRO_POWER_NORMAL;
+  _sleepWakeUs = L3GD20_SLEEP_WAKE_US;
+  _powerDownWakeUs = L3GD20_POWERDOWN_WAKE_US;
+  _settleUntil = 0;
+  _settling = false;
+  _dutyState = GYRO_DUTY_OFF;
+  _dutyIdle = GYRO_POWER_SLEEP;
+  _dutyInterval = 0;
+  _dutyStart = 0;
+  _dutyNext = 0;
+  _dutyBatch = 0;
+  _range = GYRO_RANGE_250DPS;
+  _rangeFloor = GYRO_RANGE_250DPS;
+  _staleRange = GYRO_RANGE_250DPS;
+  _staleSamples = 0;
+  _rangeSettling = false;
+  _rangeDownPercent = L3GD20_RANGE_DOWN_PERCENT;
+  _rangeDownSamples = L3GD20_RANGE_DOWN_SAMPLES;
+  _rangeCalm = 0;
+  _biasEnabled = false;
+  _biasLearning = false;
+  memset(&_biasTable, 0, sizeof(_biasTable));
+  memset(_stillMean, 0, sizeof(_stillMean));
+  memset(_stillM2, 0, sizeof(_stillM2));
+  _stillCount = 0;
+  _temperatureTime = 0;
+  _shadowValid = 0;
+  _shadowDirty = 0;
+  _clockBase = 0;
+  _clockFrac = 0;
+  _clockPeriod = (uint32_t)nominalPeriod() << 8;
+  _clockSpan = 0;
+  _clockSync = 0;
+  _irqTime = 0;
+  _irqPending = false;
+  timestamp = 0;
+  temperature = 0;
+  overruns = 0;
+  _ring = NULL;
+  _ringTimes = NULL;
+  _ringMask = 0;
+  _ringHead = 0;
+  _ringTail = 0;
+  _ringStale = false;
+  _ringPending = 0;
+  _ringMark = 0;
+  _ringStaleRange = GYRO_RANGE_250DPS;
+  _ringRange = GYRO_RANGE_250DPS;
+  droppedSamples = 0;
+  _readStatus = GYRO_READ_IDLE;
+  _readStep = 0;
+  _readSkip = 0;
+  _readFrom = GYRO_REGISTER_OUT_X_L;
+  _readLength = 6;
+  _readAttempts = 0;
+  _readRetries = L3GD20_ASYNC_RETRIES;
+  _readTimeout = L3GD20_ASYNC_TIMEOUT_MS;
+  _readStart = 0;
+  _readTimestamp = 0;
+  _selected = 0;
+  _captureFunc = NULL;
+  _captureContext = NULL;
+  _captureEnd = 0;
+#ifdef L3GD20_BUS_REPLAY
+  _replayFunc = NULL;
+  _replayContext = NULL;
+#endif
+}
+
+/***************************************************************************
+ PUBLIC FUNCTIONS
+ ***************************************************************************/
+
+/**************************************************************************/
+/**
+    @brief  Setups the HW
+
+    @param  rng     The 'gyroRange_t' to use when configuring the sensor.
+    @param  theWire Optional parameter for the I2C device we will use.
+                    Default is "Wire". Ignored when using SPI.
+    @param  addr    Optional I2C address of the sensor, L3GD20_ADDRESS
+                    (SDO high, the default) or L3GD20_ADDRESS_ALT (SDO low).
+                    Ignored when using SPI.
+
+    @return True if the 'begin' process was successful, otherwise false.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::begin(gyroRange_t rng, TwoWire *theWire,
+                                    uint8_t addr) {
+  if (_useSpi) {
+    /* Enable SPI, the bus and address arguments don't apply */
+    _spiBus.begin();
+  } else {
+    /* Set the I2C bus interface and address, then enable I2C */
+    _i2cBus = Adafruit_L3GD20_I2C(theWire, addr);
+    _i2cBus.begin();
+  }
+
+  /* Set the range the an appropriate value; auto-ranging never goes below
+     it */
+  _range = rng;
+  _rangeFloor = rng;
+  _staleSamples = 0;
+  _rangeSettling = false;
+  _rangeCalm = 0;
+
+  /* Clear the raw sensor data */
+  raw.x = 0;
+  raw.y = 0;
+  raw.z = 0;
+
+  /* Make sure we have the correct chip ID since this checks
+     for correct address and that the IC is properly connected */
+  uint8_t id = read8(GYRO_REGISTER_WHO_AM_I);
+  // Serial.println(id, HEX);
+  if ((id != L3GD20_ID) && (id != L3GD20H_ID)) {
+    return false;
+  }
+  _variant = (gyroVariant_t)id;
+  if ((_variant == GYRO_VARIANT_L3GD20) &&
+      (_dataRate > GYRO_DATARATE_760HZ)) {
+    /* No LOW_ODR on the original part, use its slowest rate */
+    _dataRate = GYRO_DATARATE_95HZ;
+  }
+
+  /* Load the register shadow in one burst, so later read-modify-writes of
+     CTRL_REG1..REFERENCE need no bus reads */
+  _shadowValid = 0;
+  _shadowDirty = 0;
+  if (readBytes(GYRO_REGISTER_CTRL_REG1, _shadow, 6)) {
+    _shadowValid = 0x3F;
+  }
+
+  /* Set CTRL_REG1 (0x20)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+   7-6  DR1/0     Output data rate                                   00
+   5-4  BW1/0     Bandwidth selection                                00
+     3  PD        0 = Power-down mode, 1 = normal/sleep mode          0
+     2  ZEN       Z-axis enable (0 = disabled, 1 = enabled)           1
+     1  YEN       Y-axis enable (0 = disabled, 1 = enabled)           1
+     0  XEN       X-axis enable (0 = disabled, 1 = enabled)           1 */
+
+  /* Reset then switch to normal mode at the selected data rate and
+     bandwidth, and enable the channels set with setAxes() */
+  writeConfig(GYRO_REGISTER_CTRL_REG1, 0x00);
+  flushConfig();
+  writeConfig(GYRO_REGISTER_CTRL_REG1,
+              (l3gd20Ctrl1(_dataRate, _bandwidth) & ~0x07) | _axes);
+  /* ------------------------------------------------------------------ */
+
+  /* Set CTRL_REG2 (0x21)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+   5-4  HPM1/0    High-pass filter mode selection                    00
+   3-0  HPCF3..0  High-pass filter cutoff frequency selection      0000 */
+
+  /* High-pass mode and cutoff as set with setHighPass() */
+  writeConfig(GYRO_REGISTER_CTRL_REG2, _highPassMode | _highPassCutoff);
+  /* ------------------------------------------------------------------ */
+
+  /* Set CTRL_REG3 (0x22)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+     7  I1_Int1   Interrupt enable on INT1 (0=disable,1=enable)       0
+     6  I1_Boot   Boot status on INT1 (0=disable,1=enable)            0
+     5  H-Lactive Interrupt active config on INT1 (0=high,1=low)      0
+     4  PP_OD     Push-Pull/Open-Drain (0=PP, 1=OD)                   0
+     3  I2_DRDY   Data ready on DRDY/INT2 (0=disable,1=enable)        0
+     2  I2_WTM    FIFO wtrmrk int on DRDY/INT2 (0=dsbl,1=enbl)        0
+     1  I2_ORun   FIFO overrun int on DRDY/INT2 (0=dsbl,1=enbl)       0
+     0  I2_Empty  FIFI empty int on DRDY/INT2 (0=dsbl,1=enbl)         0 */
+
+  /* Nothing to do ... keep default values */
+  /* ------------------------------------------------------------------ */
+
+  /* Set CTRL_REG4 (0x23)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+     7  BDU       Block Data Update (0=continuous, 1=LSB/MSB)         0
+     6  BLE       Big/Little-Endian (0=Data LSB, 1=Data MSB)          0
+   5-4  FS1/0     Full scale selection                               00
+                                  00 = 250 dps
+                                  01 = 500 dps
+                                  10 = 2000 dps
+                                  11 = 2000 dps
+     0  SIM       SPI Mode (0=4-wire, 1=3-wire)                       0 */
+
+  /* Adjust resolution if requested */
+  writeConfig(GYRO_REGISTER_CTRL_REG4, l3gd20RangeBits(_range));
+  /* ------------------------------------------------------------------ */
+
+  /* Set CTRL_REG5 (0x24)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+     7  BOOT      Reboot memory content (0=normal, 1=reboot)          0
+     6  FIFO_EN   FIFO enable (0=FIFO disable, 1=enable)              0
+     5  StopOnFTH FIFO depth limited to threshold (L3GD20H only)      0
+     4  HPen      High-pass filter enable (0=disable,1=enable)        0
+   3-2  INT1_SEL  INT1 Selection config                              00
+   1-0  OUT_SEL   Out selection config                               00 */
+
+  /* Filter path as set with setFilterPath(), leave FIFO_EN alone */
+  updateConfig(GYRO_REGISTER_CTRL_REG5, 0x13, _filterPath);
+  /* ------------------------------------------------------------------ */
+
+  /* Set REFERENCE (0x25)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+   7-0  REF7..0   High-pass reference value                    00000000 */
+
+  writeConfig(GYRO_REGISTER_REFERENCE, _reference);
+  /* ------------------------------------------------------------------ */
+
+  /* Set LOW_ODR (0x39), L3GD20H only
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+     5  DRDY_HL   DRDY/INT2 active level (0=high, 1=low)              0
+     3  I2C_dis   Disable I2C (0=SPI and I2C, 1=SPI only)             0
+     2  SW_RES    Software reset (0=normal, 1=reset)                  0
+     0  Low_ODR   Low output data rates, 12.5 to 50 Hz                0 */
+
+  if (_variant == GYRO_VARIANT_L3GD20H) {
+    writeConfig(GYRO_REGISTER_LOW_ODR, (_dataRate >> 2) & 0x01);
+  }
+  /* ------------------------------------------------------------------ */
+
+  /* CTRL_REG1..REFERENCE go out in one write, unchanged registers are
+     skipped or cheaply bridged */
+  flushConfig();
+  restartClock();
+
+  _powerMode = GYRO_POWER_NORMAL;
+  _wakeFrom = GYRO_POWER_NORMAL;
+  _settling = false;
+  _dutyState = GYRO_DUTY_OFF;
+  _initialized = true;
+
+  return true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Enables or disables auto-ranging
+
+    A saturated sample switches to the next wider range without stopping
+    the sensor; the range steps back down as set with
+    setAutoRangeHysteresis(), once the FIFO and the sample buffer are
+    empty. Samples taken before a change are returned in the units of the
+    new range, so getScale() always applies.
+
+    @param  enabled Set to 'true' to enable auto-ranging, 'false' to disable.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::enableAutoRange(bool enabled) {
+  _autoRangeEnabled = enabled;
+}
+
+/**************************************************************************/
+/**
+    @brief  Enables or disables status reads
+
+    Each read then starts at OUT_TEMP, taking the die temperature and
+    STATUS_REG in the same transaction as the sample, for two more bytes.
+    With the FIFO off, a read that finds no new sample fails instead of
+    returning the previous one again (getEvent() returns false, pollRead()
+    GYRO_READ_STALE), and overwritten samples are counted in 'overruns'.
+    readFifo() and handleInterrupt() read OUT_TEMP on its own, at most
+    every L3GD20_TEMP_INTERVAL_MS.
+
+    @param  enabled Set to 'true' to enable status reads, 'false' to
+                    disable.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::enableStatusRead(bool enabled) {
+  _statusRead = enabled;
+  /* Have the next FIFO drain read OUT_TEMP */
+  _temperatureTime = millis() - L3GD20_TEMP_INTERVAL_MS;
+}
+
+/**************************************************************************/
+/**
+    @brief  Enables or disables zero-rate bias compensation
+
+    While learning, the driver watches the samples it reads for still
+    periods and estimates the bias of each axis from them, per temperature
+    bin. The bias at the current temperature is subtracted by getEvent(),
+    getEventFixed(), completeRead() and the convertSamples() functions; raw
+    samples are left as read. Temperature comes with status reads (see
+    enableStatusRead()); without them a single bias is learned.
+
+    @param  enabled Set to 'true' to subtract the bias, 'false' to disable.
+    @param  learn   Set to 'false' to only apply the table, e.g. one
+                    restored with setBiasTable().
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::enableBiasCompensation(bool enabled,
+                                                     bool learn) {
+  _biasEnabled = enabled;
+  _biasLearning = enabled && learn;
+  _stillCount = 0;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the learned bias table, e.g. to save it
+
+    @param  table   The placeholder where the table is written.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::getBiasTable(gyroBiasTable_t *table) {
+  *table = _biasTable;
+}
+
+/**************************************************************************/
+/**
+    @brief  Replaces the bias table, e.g. with one saved earlier
+
+    @param  table   The table to use. A table with no valid bins clears
+                    the learned bias.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setBiasTable(const gyroBiasTable_t *table) {
+  _biasTable = *table;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the bias subtracted at the current temperature, in rad/s
+
+    @param  bias    The placeholder for the bias of the X, Y and Z axes;
+                    zero when compensation is off or nothing was learned.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::getBias(float *bias) {
+  int32_t sixteenths[3] = {0, 0, 0};
+
+  currentBias(sixteenths);
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    bias[axis] = sixteenths[axis] * (GYRO_SCALE_250DPS / 16);
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the bias subtracted at the current temperature, in
+            millidegrees per second
+
+    @param  bias    The placeholder for the bias; zero when compensation
+                    is off or nothing was learned.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::getBiasFixed(gyroFixedData_t *bias) {
+  int32_t sixteenths[3] = {0, 0, 0};
+
+  /* 1/16 LSB at 250 dps is 35/64 mdps */
+  currentBias(sixteenths);
+  bias->x = (sixteenths[0] * 35 + 32) >> 6;
+  bias->y = (sixteenths[1] * 35 + 32) >> 6;
+  bias->z = (sixteenths[2] * 35 + 32) >> 6;
+}
+
+/**************************************************************************/
+/**
+    @brief  Sets when auto-ranging steps back down to a narrower range
+
+    @param  percent The level, in percent of the narrower range's full
+                    scale, every axis must stay below. Default
+                    L3GD20_RANGE_DOWN_PERCENT.
+    @param  samples The number of consecutive samples that must stay
+                    below it. Default L3GD20_RANGE_DOWN_SAMPLES.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setAutoRangeHysteresis(uint8_t percent,
+                                                     uint16_t samples) {
+  _rangeDownPercent = (percent > 100) ? 100 : percent;
+  _rangeDownSamples = samples;
+}
+
+/**************************************************************************/
+/**
+    @brief  Sets the output data rate and low-pass cutoff
+
+    Can be called before 'begin', or afterwards to change the rate on the
+    fly. The rates below 95 Hz need an L3GD20H; the L3GD20 runs at 95 Hz
+    instead.
+
+    @param  rate      The 'gyroDataRate_t' to use.
+    @param  bandwidth The 'gyroBandwidth_t' cutoff selection to use. See
+                      'gyroBandwidth_t' for the resulting frequencies.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setDataRate(gyroDataRate_t rate,
+                                          gyroBandwidth_t bandwidth) {
+  if (_initialized && (_variant == GYRO_VARIANT_L3GD20) &&
+      (rate > GYRO_DATARATE_760HZ)) {
+    rate = GYRO_DATARATE_95HZ;
+  }
+  _dataRate = rate;
+  _bandwidth = bandwidth;
+
+  if (_initialized) {
+    updateConfig(GYRO_REGISTER_CTRL_REG1, 0xF0, l3gd20Ctrl1(rate, bandwidth));
+    if (_variant == GYRO_VARIANT_L3GD20H) {
+      updateConfig(GYRO_REGISTER_LOW_ODR, 0x01, rate >> 2);
+    }
+    flushConfig();
+    restartClock();
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the output data rate
+
+    @return The current 'gyroDataRate_t'.
+*/
+/**************************************************************************/
+gyroDataRate_t Adafruit_L3GD20_Unified::getDataRate(void) { return _dataRate; }
+
+/**************************************************************************/
+/**
+    @brief  Gets the low-pass cutoff selection
+
+    @return The current 'gyroBandwidth_t'.
+*/
+/**************************************************************************/
+gyroBandwidth_t Adafruit_L3GD20_Unified::getBandwidth(void) {
+  return _bandwidth;
+}
+
+/**************************************************************************/
+/**
+    @brief  Selects the axes to measure
+
+    getEvent() and the other single sample reads then only transfer the
+    smallest register window holding the enabled axes, e.g. 2 bytes
+    instead of 6 for yaw alone. FIFO reads still transfer all three, as
+    the FIFO stores them together. Disabled axes read 0 everywhere and
+    are skipped by the conversions. Can be called before 'begin', or
+    afterwards to change the axes on the fly.
+
+    @param  axes    The 'gyroAxes_t' flags to enable; 0 enables all.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setAxes(uint8_t axes) {
+  _axes = (axes & GYRO_AXIS_ALL) ? (axes & GYRO_AXIS_ALL) : GYRO_AXIS_ALL;
+
+  /* Asleep or powered down, the axes are switched on by the next wake */
+  if (_initialized && (_powerMode == GYRO_POWER_NORMAL)) {
+    updateConfig(GYRO_REGISTER_CTRL_REG1, 0x07, _axes);
+    flushConfig();
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the enabled axes
+
+    @return The 'gyroAxes_t' flags set with setAxes().
+*/
+/**************************************************************************/
+uint8_t Adafruit_L3GD20_Unified::getAxes(void) { return _axes; }
+
+/**************************************************************************/
+/**
+    @brief  Switches between normal, sleep and power-down mode
+
+    Sleep mode turns the axes off but keeps the drive running, so the
+    sensor wakes within a few milliseconds. Power-down also stops the
+    drive and draws almost nothing, but takes much longer to wake. On a
+    wake the sample clock restarts, and the samples taken within the wake
+    latency set with setWakeLatency() are discarded by every read path:
+    reads return nothing new until the output has settled. The latency is
+    that of the deepest mode entered since the last wake, so going from
+    power-down through sleep still waits for the drive. The register
+    contents and the FIFO settings are kept in every mode, but the FIFO is
+    emptied on a wake.
+
+    @param  mode    The 'gyroPowerMode_t' to switch to.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setPowerMode(gyroPowerMode_t mode) {
+  if (mode == _powerMode) {
+    return;
+  }
+  _powerMode = mode;
+  if (!_initialized) {
+    return;
+  }
+
+  /* PD and the axis enables of CTRL_REG1: sleep is PD set with every axis
+     off */
+  switch (mode) {
+  case GYRO_POWER_NORMAL:
+    updateConfig(GYRO_REGISTER_CTRL_REG1, 0x0F, 0x08 | _axes);
+    break;
+  case GYRO_POWER_SLEEP:
+    updateConfig(GYRO_REGISTER_CTRL_REG1, 0x0F, 0x08);
+    break;
+  case GYRO_POWER_DOWN:
+    updateConfig(GYRO_REGISTER_CTRL_REG1, 0x0F, 0x00);
+    break;
+  }
+  flushConfig();
+
+  /* Going through sleep on the way out of power-down doesn't shorten the
+     wake */
+  if ((mode != GYRO_POWER_NORMAL) && (_wakeFrom != GYRO_POWER_DOWN)) {
+    _wakeFrom = mode;
+  }
+
+  if (mode == GYRO_POWER_NORMAL) {
+    if (_fifoMode != GYRO_FIFO_BYPASS) {
+      /* Entries from before the sleep can't be stamped by the restarted
+         clock; passing through bypass mode empties the FIFO */
+      const uint8_t fifoCtrl = readConfig(GYRO_REGISTER_FIFO_CTRL_REG);
+      writeConfig(GYRO_REGISTER_FIFO_CTRL_REG, GYRO_FIFO_BYPASS);
+      flushConfig();
+      writeConfig(GYRO_REGISTER_FIFO_CTRL_REG, fifoCtrl);
+      flushConfig();
+      _staleSamples = 0;
+    }
+    restartClock();
+    _settleUntil = micros() + getWakeLatency(_wakeFrom);
+    _settling = true;
+    _wakeFrom = GYRO_POWER_NORMAL;
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the power mode
+
+    @return The 'gyroPowerMode_t' set with setPowerMode().
+*/
+/**************************************************************************/
+gyroPowerMode_t Adafruit_L3GD20_Unified::getPowerMode(void) {
+  return _powerMode;
+}
+
+/**************************************************************************/
+/**
+    @brief  Sets how long the output takes to settle after a wake
+
+    The defaults, L3GD20_SLEEP_WAKE_US and L3GD20_POWERDOWN_WAKE_US, are
+    conservative; measure a part and shorten them to save power.
+
+    @param  sleepUs     Settling time after sleep mode, in us.
+    @param  powerDownUs Settling time after power-down mode, in us.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setWakeLatency(uint32_t sleepUs,
+                                             uint32_t powerDownUs) {
+  _sleepWakeUs = sleepUs;
+  _powerDownWakeUs = powerDownUs;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets how long the output takes to settle after a wake
+
+    @param  from    The 'gyroPowerMode_t' the sensor wakes from.
+
+    @return The time in us during which samples are discarded.
+*/
+/**************************************************************************/
+uint32_t Adafruit_L3GD20_Unified::getWakeLatency(gyroPowerMode_t from) {
+  switch (from) {
+  case GYRO_POWER_SLEEP:
+    return _sleepWakeUs;
+  case GYRO_POWER_DOWN:
+    return _powerDownWakeUs;
+  default:
+    return 0;
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Tells whether the output is still settling after a wake
+
+    @return True until the first sample taken after the wake latency has
+            been read.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::isSettling(void) { return _settling; }
+
+/**************************************************************************/
+/**
+    @brief  Sets the mode and cutoff of the high-pass filter
+
+    The filter only affects the data on a path selected with
+    setFilterPath(). Can be called before 'begin', or afterwards to change
+    the filter on the fly.
+
+    @param  mode    The 'gyroHighPassMode_t' to use.
+    @param  cutoff  The 'gyroHighPassCutoff_t' selection to use. See
+                    'gyroHighPassCutoff_t' for the resulting frequencies.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setHighPass(gyroHighPassMode_t mode,
+                                          gyroHighPassCutoff_t cutoff) {
+  _highPassMode = mode;
+  _highPassCutoff = cutoff;
+
+  if (_initialized) {
+    writeConfig(GYRO_REGISTER_CTRL_REG2, mode | cutoff);
+    flushConfig();
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Selects the filters the output registers and the FIFO are fed
+            from
+
+    Takes effect with the next sample; samples already in the FIFO keep
+    the filtering they were taken with. With the high-pass filter on the
+    path the sensor removes slow drift itself, so bias compensation has
+    nothing left to learn.
+
+    @param  path    The 'gyroFilterPath_t' to use.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setFilterPath(gyroFilterPath_t path) {
+  _filterPath = path;
+
+  if (_initialized) {
+    updateConfig(GYRO_REGISTER_CTRL_REG5, 0x13, path);
+    flushConfig();
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Sets the value the high-pass filter subtracts in
+            GYRO_HIGHPASS_REFERENCE mode
+
+    @param  reference   The REFERENCE register value.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setReference(uint8_t reference) {
+  _reference = reference;
+
+  if (_initialized) {
+    writeConfig(GYRO_REGISTER_REFERENCE, reference);
+    flushConfig();
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Resets the high-pass filter, so its output starts again from
+            the current rate
+
+    Only has an effect in GYRO_HIGHPASS_NORMAL_RESET mode, where reading
+    REFERENCE is what resets the filter. The read goes to the bus on
+    purpose, the shadowed value is not used.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::resetHighPass(void) {
+  read8(GYRO_REGISTER_REFERENCE);
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the time between two samples at the current data rate
+
+    @return The sample period in microseconds.
+*/
+/**************************************************************************/
+uint32_t Adafruit_L3GD20_Unified::getSamplePeriod(void) {
+  return nominalPeriod();
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the time between two samples as measured against micros()
+
+    The sensor oscillator is only as accurate as its tolerance allows. The
+    period is tracked from the interrupt times given to markInterrupt() and
+    from the FIFO levels seen by readFifo() and handleInterrupt().
+
+    @return The sample period in nanoseconds.
+*/
+/**************************************************************************/
+uint32_t Adafruit_L3GD20_Unified::getMeasuredPeriod(void) {
+  return (_clockPeriod * 125) >> 5;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the chip found by 'begin'
+
+    @return The 'gyroVariant_t' read from WHO_AM_I.
+*/
+/**************************************************************************/
+gyroVariant_t Adafruit_L3GD20_Unified::getVariant(void) { return _variant; }
+
+/**************************************************************************/
+/**
+    @brief  Gets the most recent sensor event, containing a new sample
+            from the sensor.
+
+    @param  event   Pointer to the placeholder where the sensor event data
+                    should be written.
+
+    @return True if the event was successfully read, otherwise false.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::getEvent(sensors_event_t *event) {
+  /* Clear the event */
+  memset(event, 0, sizeof(sensors_event_t));
+
+  event->version = sizeof(sensors_event_t);
+  event->sensor_id = _sensorID;
+  event->type = SENSOR_TYPE_GYROSCOPE;
+
+  if (!readSample()) {
+    return false;
+  }
+
+  /* When the sensor took the sample, rather than when it was asked for */
+  event->timestamp = millisAt(timestamp);
+  scaleEvent(event);
+
+  return true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Reads a new sample as integer millidegrees per second
+
+    Uses no floating point, for targets without an FPU.
+
+    @param  data    Pointer to the placeholder where the sample should be
+                    written.
+
+    @return True if the sample was successfully read, otherwise false.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::getEventFixed(gyroFixedData_t *data) {
+  if (!readSample()) {
+    return false;
+  }
+
+  convertSamplesFixed(&raw, data, 1);
+
+  return true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Starts a non-blocking read of a new sample
+
+    Call pollRead() until it no longer returns GYRO_READ_BUSY, then collect
+    the sample with completeRead(). Each pollRead() call performs at most
+    one bus transaction, so other devices on the bus can be serviced in
+    between.
+
+    @return True if the read was started, false if one is already running.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::startRead(void) {
+  if (_readStatus == GYRO_READ_BUSY) {
+    return false;
+  }
+
+  _readStatus = GYRO_READ_BUSY;
+  _readStep = 0;
+  _readAttempts = 0;
+  _readStart = millis();
+
+  return true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Advances the non-blocking read by one bus transaction
+
+    @return GYRO_READ_BUSY while the read is in progress, GYRO_READ_DONE once
+            a sample is ready, GYRO_READ_STALE if a status read found no
+            new sample or the sensor is not measuring or still settling, or
+            GYRO_READ_ERROR if the retry budget or the
+            timeout set with setReadLimits() ran out.
+*/
+/**************************************************************************/
+gyroReadStatus_t Adafruit_L3GD20_Unified::pollRead(void) {
+  if (_readStatus != GYRO_READ_BUSY) {
+    return _readStatus;
+  }
+
+  bool ok;
+  switch (_readStep) {
+  case 0:
+    if (_powerMode != GYRO_POWER_NORMAL) {
+      _readStatus = GYRO_READ_STALE;
+      return _readStatus;
+    }
+    /* Address phase, including STATUS_REG right after a range change and
+       OUT_TEMP for status reads */
+    _readSkip = _statusRead ? 2 : (_rangeSettling ? 1 : 0);
+    _readFrom = outputWindow(_readSkip, &_readLength);
+    ok = selectRegister(_readFrom);
+    break;
+  default: {
+    /* Data phase */
+    uint8_t b[8];
+    const uint8_t skip = _readSkip;
+    uint32_t start = micros();
+    ok = receiveBytes(b, _readLength);
+    if (ok) {
+      if ((skip == 2) && !parseStatus(b)) {
+        _readStatus = GYRO_READ_STALE;
+        return _readStatus;
+      }
+      /* The registers are sampled during the data phase, stamp it the way
+         readOutput() does */
+      syncOutput(start + (micros() - start) / 2);
+      if (!settled(timestamp)) {
+        _readStatus = GYRO_READ_STALE;
+        return _readStatus;
+      }
+      decodeOutput(b, _readFrom, &raw);
+      autoRange(&raw, 1, staleOutput(skip ? b[skip - 1] : 0));
+      trackBias(&raw, 1);
+      _readTimestamp = timestamp;
+      _readStatus = GYRO_READ_DONE;
+      return _readStatus;
+    }
+    break;
+  }
+  }
+
+  if (ok) {
+    _readStep++;
+  } else if ((++_readAttempts > _readRetries) ||
+             ((millis() - _readStart) > _readTimeout)) {
+    _readStatus = GYRO_READ_ERROR;
+  } else {
+    /* Start over with the address phase */
+    _readStep = 0;
+  }
+
+  return _readStatus;
+}
+
+/**************************************************************************/
+/**
+    @brief  Collects the result of a non-blocking read
+
+    @param  event   Pointer to the placeholder where the sensor event data
+                    should be written.
+
+    @return True if a sample was available, otherwise false. Either way the
+            reader returns to GYRO_READ_IDLE.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::completeRead(sensors_event_t *event) {
+  gyroReadStatus_t status = _readStatus;
+
+  if (status == GYRO_READ_BUSY) {
+    return false;
+  }
+  _readStatus = GYRO_READ_IDLE;
+  if (status != GYRO_READ_DONE) {
+    return false;
+  }
+
+  memset(event, 0, sizeof(sensors_event_t));
+  event->version = sizeof(sensors_event_t);
+  event->sensor_id = _sensorID;
+  event->type = SENSOR_TYPE_GYROSCOPE;
+  event->timestamp = millisAt(_readTimestamp);
+  scaleEvent(event);
+
+  return true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Sets the failure budget of the non-blocking read
+
+    @param  retries   Number of failed transactions tolerated per read.
+    @param  timeoutMs Maximum time in milliseconds a read may take.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setReadLimits(uint8_t retries,
+                                            uint16_t timeoutMs) {
+  _readRetries = retries;
+  _readTimeout = timeoutMs;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the sensor_t data, describing the features of this sensor.
+
+    @param  sensor  The plaxceholder where the 'sensor_t' data should be
+                    written.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::getSensor(sensor_t *sensor) {
+  /* Clear the sensor_t object */
+  memset(sensor, 0, sizeof(sensor_t));
+
+  /* Insert the sensor name in the fixed length char array */
+  strncpy(sensor->name,
+          (_variant == GYRO_VARIANT_L3GD20H) ? "L3GD20H" : "L3GD20",
+          sizeof(sensor->name) - 1);
+  sensor->name[sizeof(sensor->name) - 1] = 0;
+  sensor->version = 1;
+  sensor->sensor_id = _sensorID;
+  sensor->type = SENSOR_TYPE_GYROSCOPE;
+  sensor->min_delay = nominalPeriod();
+  sensor->max_value = (float)this->_range * SENSORS_DPS_TO_RADS;
+  sensor->min_value = (this->_range * -1.0) * SENSORS_DPS_TO_RADS;
+  sensor->resolution = 0.0F; // TBD
+}
+
+/**************************************************************************/
+/**
+    @brief  Configures the hardware FIFO
+
+    @param  mode      The 'gyroFifoMode_t' to use. GYRO_FIFO_BYPASS disables
+                      the FIFO. On the L3GD20, GYRO_FIFO_DYNAMIC_STREAM
+                      falls back to stream and GYRO_FIFO_BYPASS_TO_FIFO
+                      to bypass-to-stream.
+    @param  watermark FIFO level (0..31) at which the WTM flag is raised.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::enableFifo(gyroFifoMode_t mode,
+                                         uint8_t watermark) {
+  /* Set FIFO_CTRL_REG (0x2E)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+   7-5  FM2..0    FIFO mode selection                               000
+   4-0  WTM4..0   FIFO threshold (watermark level)                00000 */
+
+  /* The L3GD20 lacks the two modes the L3GD20H added */
+  if (_variant == GYRO_VARIANT_L3GD20) {
+    if (mode == GYRO_FIFO_DYNAMIC_STREAM) {
+      mode = GYRO_FIFO_STREAM;
+    } else if (mode == GYRO_FIFO_BYPASS_TO_FIFO) {
+      mode = GYRO_FIFO_BYPASS_TO_STREAM;
+    }
+  }
+
+  /* Passing through bypass mode empties the FIFO and clears any overrun */
+  writeConfig(GYRO_REGISTER_FIFO_CTRL_REG, GYRO_FIFO_BYPASS);
+  flushConfig();
+  _fifoMode = mode;
+  _staleSamples = 0;
+  _rangeSettling = false;
+
+  if (mode == GYRO_FIFO_BYPASS) {
+    updateConfig(GYRO_REGISTER_CTRL_REG5, 0x40, 0x00);
+  } else {
+    updateConfig(GYRO_REGISTER_CTRL_REG5, 0x40, 0x40);
+    writeConfig(GYRO_REGISTER_FIFO_CTRL_REG, mode | (watermark & 0x1F));
+  }
+  flushConfig();
+
+  /* The FIFO starts with the first sample after now */
+  seekClock(micros());
+  advanceClock(1);
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the number of unread samples in the hardware FIFO
+
+    @return The number of samples waiting in the FIFO (0..32).
+*/
+/**************************************************************************/
+uint8_t Adafruit_L3GD20_Unified::getFifoLevel(void) {
+  /* Read FIFO_SRC_REG (0x2F)
+   ====================================================================
+   BIT  Symbol    Description
+   ---  ------    ---------------------------------------------
+     7  WTM       FIFO level is greater than or equal to watermark
+     6  OVRN      FIFO is full and at least one sample was lost
+     5  EMPTY     FIFO is empty
+   4-0  FSS4..0   FIFO stored data level */
+  uint8_t src = read8(GYRO_REGISTER_FIFO_SRC_REG);
+
+  if (src & 0x20) {
+    return 0;
+  }
+  if (src & 0x40) {
+    return L3GD20_FIFO_SIZE;
+  }
+  return src & 0x1F;
+}
+
+/**************************************************************************/
+/**
+    @brief  Drains the hardware FIFO using auto-increment burst reads
+
+    The output address rolls over from OUT_Z_H back to OUT_X_L while the
+    FIFO is enabled, so consecutive samples are read back to back. Each
+    burst holds as many samples as fit in the Wire receive buffer.
+
+    @param  buf         The placeholder where the raw samples are
+                        written, oldest first.
+    @param  max         The maximum number of samples to write to 'buf'.
+    @param  timestamps  Optional placeholder for the micros() time each
+                        sample was taken, or NULL.
+
+    @return The number of samples written to 'buf'.
+*/
+/**************************************************************************/
+size_t Adafruit_L3GD20_Unified::readFifo(gyroRawData_t *buf, size_t max,
+                                         uint32_t *timestamps) {
+  size_t count = syncFifo();
+
+  if (count > max) {
+    count = max;
+  }
+
+  return drainFifo(buf, count, timestamps);
+}
+
+/**************************************************************************/
+/**
+    @brief  Routes the data-ready and FIFO watermark signals to the DRDY/INT2
+            pin
+
+    @param  dataReady Set to 'true' to raise DRDY/INT2 on every new sample.
+    @param  watermark Set to 'true' to raise DRDY/INT2 when the FIFO level
+                      reaches the watermark passed to enableFifo().
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::enableInterrupts(bool dataReady,
+                                               bool watermark) {
+  uint8_t ctrl3 = 0;
+
+  if (dataReady) {
+    ctrl3 |= 0x08; // I2_DRDY
+  }
+  if (watermark) {
+    ctrl3 |= 0x04; // I2_WTM
+  }
+  updateConfig(GYRO_REGISTER_CTRL_REG3, 0x0C, ctrl3);
+  flushConfig();
+}
+
+/**************************************************************************/
+/**
+    @brief  Arms the INT1 threshold engine and routes it to the INT1 pin
+
+    The pin rises when the selected events have held for 'duration'
+    samples, and stays high until handleMotionInterrupt() reads the
+    source. The sensor keeps checking while the MCU sleeps, with no bus
+    traffic. Thresholds follow range changes, auto-ranging included.
+
+    @param  events      The 'gyroMotionEvent_t' flags to watch.
+    @param  thresholds  The rate threshold of each axis in mdps (0 to the
+                        full scale of the range).
+    @param  duration    Samples an event must persist before the pin rises
+                        (0..127).
+    @param  all         Set to 'true' to require all events together
+                        (AND), 'false' for any of them (OR).
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::enableMotionInterrupt(
+    uint8_t events, const gyroFixedData_t *thresholds, uint8_t duration,
+    bool all) {
+  _motionThreshold = *thresholds;
+  _motionEnabled = true;
+  writeMotionThresholds();
+
+  /* Set INT1_CFG (0x30)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+     7  AND/OR    Combination of events (0=OR, 1=AND)                 0
+     6  LIR       Latch interrupt request (0=no, 1=until read)        0
+   5-0  ZHIE..XLIE  High/low event enables per axis              000000 */
+  uint8_t cfg = 0x40 | (events & 0x3F);
+  if (all) {
+    cfg |= 0x80;
+  }
+  writeConfig(GYRO_REGISTER_INT1_CFG, cfg);
+
+  /* Set INT1_DURATION (0x38)
+   ====================================================================
+   BIT  Symbol    Description                                   Default
+   ---  ------    --------------------------------------------- -------
+     7  WAIT      Hold the pin for 'duration' after the event         0
+   6-0  D6..0     Minimum event duration in samples             0000000 */
+  writeConfig(GYRO_REGISTER_INT1_DURATION, duration & 0x7F);
+
+  /* I1_Int1 in CTRL_REG3 */
+  updateConfig(GYRO_REGISTER_CTRL_REG3, 0x80, 0x80);
+  flushConfig();
+
+  /* A request latched before the new configuration would hold the pin */
+  read8(GYRO_REGISTER_INT1_SRC);
+}
+
+/**************************************************************************/
+/**
+    @brief  Disarms the INT1 threshold engine and releases the INT1 pin
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::disableMotionInterrupt(void) {
+  _motionEnabled = false;
+  writeConfig(GYRO_REGISTER_INT1_CFG, 0x00);
+  updateConfig(GYRO_REGISTER_CTRL_REG3, 0x80, 0x00);
+  flushConfig();
+  read8(GYRO_REGISTER_INT1_SRC);
+}
+
+/**************************************************************************/
+/**
+    @brief  Reads and clears the INT1 source after the pin rose
+
+    Call it from loop() once the pin interrupt has woken the MCU; the read
+    re-arms the pin.
+
+    @return The 'gyroMotionEvent_t' flags that triggered, or 0 if no
+            interrupt was pending.
+*/
+/**************************************************************************/
+uint8_t Adafruit_L3GD20_Unified::handleMotionInterrupt(void) {
+  /* Read INT1_SRC (0x31)
+   ====================================================================
+   BIT  Symbol    Description
+   ---  ------    ---------------------------------------------
+     6  IA        One or more interrupts have been generated
+   5-0  ZH..XL    High/low event per axis */
+  uint8_t src = read8(GYRO_REGISTER_INT1_SRC);
+
+  return (src & 0x40) ? (src & 0x3F) : 0;
+}
+
+/**************************************************************************/
+/**
+    @brief  Records the time of a DRDY/INT2 interrupt
+
+    Call it first thing in the pin interrupt handler. The next read uses
+    the time to place its samples and to correct the sample clock, which
+    is far more precise than inferring it from the read itself.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::markInterrupt(void) {
+  _irqTime = micros();
+  __atomic_store_n(&_irqPending, true, __ATOMIC_RELEASE);
+}
+
+/**************************************************************************/
+/**
+    @brief  Provides the storage for the interrupt sample buffer
+
+    @param  storage     The array handleInterrupt() fills with raw samples.
+    @param  size        The number of elements in 'storage'. Must be a
+                        power of two between 2 and 128.
+    @param  timestamps  Optional array of 'size' elements for the micros()
+                        time of each sample, or NULL.
+
+    @return True if the buffer was accepted, otherwise false.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::attachSampleBuffer(gyroRawData_t *storage,
+                                                 uint8_t size,
+                                                 uint32_t *timestamps) {
+  if ((storage == NULL) || (size < 2) || (size > 128) ||
+      (size & (size - 1))) {
+    return false;
+  }
+
+  _ring = storage;
+  _ringTimes = timestamps;
+  _ringMask = size - 1;
+  _ringHead = 0;
+  _ringTail = 0;
+  _ringStale = false;
+  droppedSamples = 0;
+
+  return true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Moves the pending samples from the sensor into the sample buffer
+
+    This is the producer side of the sample buffer. Call it from the
+    DRDY/INT2 pin interrupt on cores whose Wire implementation may be used
+    in interrupt context, otherwise set a flag in the interrupt and call it
+    from loop(). With the FIFO enabled the whole FIFO is drained, otherwise
+    the current output registers are read. Calling markInterrupt() in the
+    interrupt itself makes the sample timestamps exact.
+
+    @return The number of samples added to the buffer.
+*/
+/**************************************************************************/
+size_t Adafruit_L3GD20_Unified::handleInterrupt(void) {
+  if (_ring == NULL) {
+    return 0;
+  }
+
+  uint8_t head = _ringHead;
+  uint8_t tail = __atomic_load_n(&_ringTail, __ATOMIC_ACQUIRE);
+  uint8_t space = (_ringMask + 1) - (uint8_t)(head - tail);
+  size_t added = 0;
+
+  const gyroRange_t range = _range;
+  uint8_t mark = head;
+
+  if (_fifoMode == GYRO_FIFO_BYPASS) {
+    gyroRawData_t sample;
+    if (readOutput(&sample) != GYRO_READ_DONE) {
+      return 0;
+    }
+    if (space == 0) {
+      droppedSamples++;
+    } else {
+      _ring[head & _ringMask] = sample;
+      if (_ringTimes != NULL) {
+        _ringTimes[head & _ringMask] = timestamp;
+      }
+      added = 1;
+    }
+  } else {
+    /* Samples that don't fit stay in the FIFO for the next call */
+    uint8_t count = syncFifo();
+    if (count > space) {
+      count = space;
+    }
+    /* Drain straight into the ring, in two parts if it wraps around */
+    while (added < count) {
+      uint8_t index = (head + added) & _ringMask;
+      uint8_t n = (_ringMask + 1) - index;
+      if (n > count - added) {
+        n = count - added;
+      }
+      const gyroRange_t before = _range;
+      _ringPending = added;
+      size_t got = drainFifo(&_ring[index], n,
+                             _ringTimes ? &_ringTimes[index] : NULL);
+      if (_range != before) {
+        /* This part was rescaled to the new range, an earlier part of the
+           same drain was not */
+        mark = head + added;
+      }
+      added += got;
+      if (got < n) {
+        break;
+      }
+    }
+  }
+
+  /* The samples from the mark on are at the new range, the ones before
+     still at the old one; readSamples() rescales those */
+  if (_range != range) {
+    _ringMark = mark;
+    _ringStaleRange = range;
+    _ringRange = _range;
+    __atomic_store_n(&_ringStale, true, __ATOMIC_RELEASE);
+  }
+
+  _ringPending = 0;
+  __atomic_store_n(&_ringHead, (uint8_t)(head + added), __ATOMIC_RELEASE);
+
+  return added;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the number of samples waiting in the sample buffer
+
+    @return The number of samples readSamples() can return.
+*/
+/**************************************************************************/
+size_t Adafruit_L3GD20_Unified::available(void) {
+  uint8_t head = __atomic_load_n(&_ringHead, __ATOMIC_ACQUIRE);
+  return (uint8_t)(head - _ringTail);
+}
+
+/**************************************************************************/
+/**
+    @brief  Takes a batch of samples from the sample buffer
+
+    This is the consumer side of the sample buffer and must only be called
+    from one context, typically loop().
+
+    @param  buf         The placeholder where the raw samples are
+                        written, oldest first.
+    @param  max         The maximum number of samples to write to 'buf'.
+    @param  timestamps  Optional placeholder for the micros() time of each
+                        sample, or NULL. Needs a timestamp array given to
+                        attachSampleBuffer().
+
+    @return The number of samples written to 'buf'.
+*/
+/**************************************************************************/
+size_t Adafruit_L3GD20_Unified::readSamples(gyroRawData_t *buf, size_t max,
+                                            uint32_t *timestamps) {
+  if (_ring == NULL) {
+    return 0;
+  }
+
+  uint8_t head = __atomic_load_n(&_ringHead, __ATOMIC_ACQUIRE);
+  bool stale = __atomic_load_n(&_ringStale, __ATOMIC_ACQUIRE);
+  uint8_t tail = _ringTail;
+  size_t count = 0;
+
+  while ((tail != head) && (count < max)) {
+    buf[count] = _ring[tail & _ringMask];
+    if ((timestamps != NULL) && (_ringTimes != NULL)) {
+      timestamps[count] = _ringTimes[tail & _ringMask];
+    }
+    if (stale && ((int8_t)(tail - _ringMark) < 0)) {
+      /* Stored before the last range change */
+      rescaleSample(&buf[count], _ringStaleRange, _ringRange);
+    }
+    count++;
+    tail++;
+  }
+
+  __atomic_store_n(&_ringTail, tail, __ATOMIC_RELEASE);
+  if (stale && ((int8_t)(tail - _ringMark) >= 0)) {
+    __atomic_store_n(&_ringStale, false, __ATOMIC_RELEASE);
+  }
+
+  return count;
+}
+
+/**************************************************************************/
+/**
+    @brief  Starts duty-cycled acquisition
+
+    Every 'intervalMs' the sensor wakes from the 'idle' mode, waits out the
+    wake latency, collects 'batch' samples in the FIFO and goes back to
+    sleep. Call pollDutyCycle() at least every getDutyCycleDelay() us to
+    move it along. Takes over the FIFO in stream mode until
+    stopDutyCycle().
+
+    @param  intervalMs  Time between the starts of two batches, in ms.
+    @param  batch       Samples per batch, 1..32.
+    @param  idle        GYRO_POWER_SLEEP or GYRO_POWER_DOWN between
+                        batches.
+
+    @return True if duty cycling started, false before 'begin' or with
+            invalid arguments.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_Unified::startDutyCycle(uint32_t intervalMs,
+                                             uint8_t batch,
+                                             gyroPowerMode_t idle) {
+  if (!_initialized || (batch == 0) || (batch > L3GD20_FIFO_SIZE) ||
+      (idle == GYRO_POWER_NORMAL)) {
+    return false;
+  }
+
+  _dutyInterval = intervalMs * 1000;
+  _dutyBatch = batch;
+  _dutyIdle = idle;
+  setPowerMode(idle);
+
+  /* The first batch starts right away */
+  _dutyState = GYRO_DUTY_IDLE;
+  _dutyStart = micros();
+  _dutyNext = _dutyStart;
+
+  return true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Advances duty-cycled acquisition
+
+    Does nothing, not even a bus access, until getDutyCycleDelay() has
+    elapsed.
+
+    @param  buf         The placeholder for a completed batch.
+    @param  max         The capacity of 'buf' in samples; samples of the
+                        batch beyond it are dropped.
+    @param  timestamps  Optional placeholder for the micros() time of each
+                        sample, or NULL.
+
+    @return The number of samples written to 'buf', 0 until a batch is
+            complete.
+*/
+/**************************************************************************/
+size_t Adafruit_L3GD20_Unified::pollDutyCycle(gyroRawData_t *buf, size_t max,
+                                              uint32_t *timestamps) {
+  if ((_dutyState == GYRO_DUTY_OFF) || ((int32_t)(micros() - _dutyNext) < 0)) {
+    return 0;
+  }
+
+  switch (_dutyState) {
+  case GYRO_DUTY_IDLE:
+    setPowerMode(GYRO_POWER_NORMAL);
+    _dutyState = GYRO_DUTY_WAKING;
+    _dutyNext = _settleUntil;
+    return 0;
+
+  case GYRO_DUTY_WAKING:
+    /* Restarting the FIFO now leaves only settled samples in it */
+    enableFifo(GYRO_FIFO_STREAM);
+    _settling = false;
+    _dutyState = GYRO_DUTY_COLLECTING;
+    _dutyNext = sampleTime(_dutyBatch - 1);
+    return 0;
+
+  default:
+    break;
+  }
+
+  uint8_t level = syncFifo();
+  if (level < _dutyBatch) {
+    /* Not there yet, come back when the last sample is due */
+    _dutyNext = sampleTime(_dutyBatch - 1);
+    return 0;
+  }
+
+  size_t got = drainFifo(buf, (max < _dutyBatch) ? max : _dutyBatch,
+                         timestamps);
+  setPowerMode(_dutyIdle);
+  _dutyState = GYRO_DUTY_IDLE;
+
+  /* Keep the cadence, unless this batch ran into the next one */
+  _dutyStart += _dutyInterval;
+  if ((int32_t)(micros() - _dutyStart) > 0) {
+    _dutyStart = micros();
+  }
+  _dutyNext = _dutyStart;
+
+  return got;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the time until pollDutyCycle() has something to do
+
+    @return The time in us, 0 if pollDutyCycle() should be called now.
+*/
+/**************************************************************************/
+uint32_t Adafruit_L3GD20_Unified::getDutyCycleDelay(void) {
+  int32_t delay = (int32_t)(_dutyNext - micros());
+
+  return ((_dutyState == GYRO_DUTY_OFF) || (delay < 0)) ? 0 : delay;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the state of duty-cycled acquisition
+
+    @return The current 'gyroDutyState_t'.
+*/
+/**************************************************************************/
+gyroDutyState_t Adafruit_L3GD20_Unified::getDutyCycleState(void) {
+  return _dutyState;
+}
+
+/**************************************************************************/
+/**
+    @brief  Stops duty-cycled acquisition
+
+    Leaves the sensor in normal mode with the FIFO off.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::stopDutyCycle(void) {
+  if (_dutyState == GYRO_DUTY_OFF) {
+    return;
+  }
+  _dutyState = GYRO_DUTY_OFF;
+  enableFifo(GYRO_FIFO_BYPASS);
+  setPowerMode(GYRO_POWER_NORMAL);
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the range samples are currently taken at
+
+    @return The range, which auto-ranging may have changed since begin().
+*/
+/**************************************************************************/
+gyroRange_t Adafruit_L3GD20_Unified::getRange(void) { return _range; }
+
+/**************************************************************************/
+/**
+    @brief  Gets the factor converting raw samples to rad/s at the current
+            range
+
+    @return The sensitivity and the dps to rad/s conversion in one factor.
+*/
+/**************************************************************************/
+float Adafruit_L3GD20_Unified::getScale(void) {
+  return l3gd20RangeScale(_range);
+}
+
+/**************************************************************************/
+/**
+    @brief  Converts a batch of raw samples to rad/s, interleaved
+
+    The scale factor is looked up once per batch and the loop body is
+    branch-free, so compilers can vectorise it where the target allows.
+
+    @param  in      The raw samples, e.g. from readFifo().
+    @param  out     The placeholder for 3 * 'count' values, written as
+                    x0, y0, z0, x1, y1, z1, ...
+    @param  count   The number of samples to convert.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::convertSamples(const gyroRawData_t *in,
+                                             float *out, size_t count) {
+  float scale[3];
+  float offset[3];
+
+  getBias(offset);
+  /* Disabled axes come out as 0 without a branch per sample */
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    scale[axis] = (_axes & (1 << axis)) ? getScale() : 0.0F;
+  }
+  for (size_t i = 0; i < count; i++) {
+    out[0] = in[i].x * scale[0] - offset[0];
+    out[1] = in[i].y * scale[1] - offset[1];
+    out[2] = in[i].z * scale[2] - offset[2];
+    out += 3;
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Converts a batch of raw samples to rad/s, one array per axis
+
+    Disabled axes are skipped, their arrays are left untouched and may be
+    NULL.
+
+    @param  in      The raw samples, e.g. from readFifo().
+    @param  x       The placeholder for 'count' X axis values.
+    @param  y       The placeholder for 'count' Y axis values.
+    @param  z       The placeholder for 'count' Z axis values.
+    @param  count   The number of samples to convert.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::convertSamples(const gyroRawData_t *in,
+                                             float *x, float *y, float *z,
+                                             size_t count) {
+  const float scale = getScale();
+  float offset[3];
+
+  getBias(offset);
+  if (_axes == GYRO_AXIS_ALL) {
+    for (size_t i = 0; i < count; i++) {
+      x[i] = in[i].x * scale - offset[0];
+      y[i] = in[i].y * scale - offset[1];
+      z[i] = in[i].z * scale - offset[2];
+    }
+    return;
+  }
+  /* One pass per enabled axis */
+  if (_axes & GYRO_AXIS_X) {
+    for (size_t i = 0; i < count; i++) {
+      x[i] = in[i].x * scale - offset[0];
+    }
+  }
+  if (_axes & GYRO_AXIS_Y) {
+    for (size_t i = 0; i < count; i++) {
+      y[i] = in[i].y * scale - offset[1];
+    }
+  }
+  if (_axes & GYRO_AXIS_Z) {
+    for (size_t i = 0; i < count; i++) {
+      z[i] = in[i].z * scale - offset[2];
+    }
+  }
+}
 
-  /* Insert the sensor name in the fixed length char array */
-  strncpy(sensor->name, "L3GD20", sizeof(sensor->name) - 1);
-  sensor->name[sizeof(sensor->name) - 1] = 0;
-  sensor->version = 1;
-  sensor->sensor_id = _sensorID;
-  sensor->type = SENSOR_TYPE_GYROSCOPE;
-  sensor->min_delay = 0;
-  sensor->max_value = (float)this->_range * SENSORS_DPS_TO_RADS;
-  sensor->min_value = (this->_range * -1.0) * SENSORS_DPS_TO_RADS;
-  sensor->resolution = 0.0F; // TBD
+/**************************************************************************/
+/**
+    @brief  Converts a batch of raw samples to millidegrees per second using
+            integer arithmetic only
+
+    The sensitivities are exact fractions (8.75 = 35/4, 17.5 = 35/2 and
+    70 mdps/LSB), so each axis costs one multiply and one shift and the
+    result is rounded to the nearest mdps.
+
+    @param  in      The raw samples, e.g. from readFifo().
+    @param  out     The placeholder for 'count' converted samples.
+    @param  count   The number of samples to convert.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::convertSamplesFixed(const gyroRawData_t *in,
+                                                  gyroFixedData_t *out,
+                                                  size_t count) {
+  int32_t mul;
+  uint8_t shift;
+
+  switch (_range) {
+  case GYRO_RANGE_500DPS:
+    mul = 35;
+    shift = 1;
+    break;
+  case GYRO_RANGE_2000DPS:
+    mul = 70;
+    shift = 0;
+    break;
+  default:
+    mul = 35;
+    shift = 2;
+    break;
+  }
+
+  gyroFixedData_t offset;
+  getBiasFixed(&offset);
+
+  /* Disabled axes come out as 0 without a branch per sample */
+  const int32_t mulX = (_axes & GYRO_AXIS_X) ? mul : 0;
+  const int32_t mulY = (_axes & GYRO_AXIS_Y) ? mul : 0;
+  const int32_t mulZ = (_axes & GYRO_AXIS_Z) ? mul : 0;
+  const int32_t round = (1 << shift) >> 1;
+  for (size_t i = 0; i < count; i++) {
+    out[i].x = ((in[i].x * mulX + round) >> shift) - offset.x;
+    out[i].y = ((in[i].y * mulY + round) >> shift) - offset.y;
+    out[i].z = ((in[i].z * mulZ + round) >> shift) - offset.z;
+  }
+}
+
+/**************************************************************************/
+/**
+    @brief  Records every bus transaction from now on
+
+    Each transaction is handed to 'func' as a record in the format of
+    l3gd20ParseCapture(), e.g. to be appended to a file on an SD card.
+    Replaying the records reproduces the driver's behaviour on the host.
+    No record buffer is kept: a record arrives in several calls, its
+    header, then its data, a sample at a time for FIFO drains, so 'func'
+    should append what it is given.
+
+    @param  func    Called with each piece of a record, NULL stops
+                    recording.
+    @param  context Passed through to 'func'.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setBusCapture(l3gd20CaptureFunc_t func,
+                                            void *context) {
+  _captureFunc = func;
+  _captureContext = context;
+  _captureEnd = micros();
+}
+
+#ifdef L3GD20_BUS_REPLAY
+/**************************************************************************/
+/**
+    @brief  Answers every bus transaction from a capture instead of the bus
+
+    Only built with L3GD20_BUS_REPLAY defined, for host tools.
+
+    @param  func    Called for each transaction, NULL goes back to the bus.
+    @param  context Passed through to 'func'.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Unified::setBusReplay(l3gd20ReplayFunc_t func,
+                                           void *context) {
+  _replayFunc = func;
+  _replayContext = context;
+}
+#endif
+
+/***************************************************************************
+ SENSOR GROUP
+ ***************************************************************************/
+
+/**************************************************************************/
+/**
+    @brief  Instantiates a group of sensors that are read together
+
+    @param  gyros   Array of sensors, each already started with 'begin'.
+    @param  count   The number of sensors in 'gyros', at most 8.
+*/
+/**************************************************************************/
+Adafruit_L3GD20_Group::Adafruit_L3GD20_Group(Adafruit_L3GD20_Unified **gyros,
+                                             uint8_t count) {
+  _gyros = gyros;
+  _count = (count > 8) ? 8 : count;
+  _first = 0;
+}
+
+/**************************************************************************/
+/**
+    @brief  Reads the latest sample of every sensor in one pass
+
+    Each sensor gets exactly one read attempt so the pass takes a bounded
+    time. The sensor read first rotates on every pass, so no sensor always
+    delivers the oldest sample. Every read goes through the same path as
+    getEvent(), so each sensor's 'raw' and 'timestamp' are updated and
+    auto-ranging and bias tracking keep running. Sensors with the FIFO
+    enabled are skipped; drain those with readFifo().
+
+    @param  samples   Array of one raw sample per sensor, in group order.
+                      Entries of sensors that failed are left untouched.
+    @param  timestamp Optional placeholder for the micros() time at the
+                      middle of the pass. The time each sample was taken is
+                      in the sensor's 'timestamp'.
+
+    @return A bit mask with bit 'i' set if sensor 'i' was read.
+*/
+/**************************************************************************/
+uint8_t Adafruit_L3GD20_Group::read(gyroRawData_t *samples,
+                                    uint32_t *timestamp) {
+  uint32_t start = micros();
+  uint8_t mask = 0;
+
+  for (uint8_t n = 0; n < _count; n++) {
+    uint8_t i = (_first + n) % _count;
+    Adafruit_L3GD20_Unified *gyro = _gyros[i];
+    gyroRawData_t sample;
+
+    /* A FIFO read returns its oldest entry, not the latest sample */
+    if (gyro->_fifoMode != GYRO_FIFO_BYPASS) {
+      continue;
+    }
+    if (gyro->readOutput(&sample) != GYRO_READ_DONE) {
+      continue;
+    }
+    gyro->raw = sample;
+    samples[i] = sample;
+    mask |= 1 << i;
+  }
+
+  if (_count > 0) {
+    _first = (_first + 1) % _count;
+  }
+  if (timestamp != NULL) {
+    *timestamp = start + (micros() - start) / 2;
+  }
+
+  return mask;
+}
+
+/***************************************************************************
+ ATTITUDE
+ ***************************************************************************/
+
+/**************************************************************************/
+/**
+    @brief  Instantiates a floating point attitude integrator at the
+            identity orientation
+*/
+/**************************************************************************/
+Adafruit_L3GD20_Attitude::Adafruit_L3GD20_Attitude(void) { reset(); }
+
+/**************************************************************************/
+/**
+    @brief  Returns to the identity orientation; the next sample starts
+            the integration
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Attitude::reset(void) {
+  _q[0] = 1.0F;
+  _q[1] = 0.0F;
+  _q[2] = 0.0F;
+  _q[3] = 0.0F;
+  _last = 0;
+  _started = false;
+}
+
+/**************************************************************************/
+/**
+    @brief  Rotates the orientation by a batch of samples
+
+    Each sample turns the body at its rate for the time since the sample
+    before it; the quaternion is normalised once per batch.
+
+    @param  samples     The raw samples, oldest first, e.g. from
+                        readFifo().
+    @param  timestamps  The micros() time of each sample.
+    @param  count       The number of samples.
+    @param  scale       The raw to rad/s factor of the samples, from
+                        getScale().
+    @param  bias        Optional rad/s to subtract from each axis, e.g.
+                        from getBias(), or NULL.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Attitude::update(const gyroRawData_t *samples,
+                                      const uint32_t *timestamps,
+                                      size_t count, float scale,
+                                      const float *bias) {
+  const float half = scale * 0.5e-6F;
+  float offset[3] = {0.0F, 0.0F, 0.0F};
+  float w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+
+  if (bias != NULL) {
+    /* Subtracted from the raw value before scaling */
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      offset[axis] = bias[axis] / scale;
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t dt = timestamps[i] - _last;
+    _last = timestamps[i];
+    if (!_started || (dt > L3GD20_ATTITUDE_MAX_GAP)) {
+      /* Nothing to integrate over yet */
+      _started = true;
+      continue;
+    }
+
+    /* Half the rotation angle about each axis */
+    const float k = half * dt;
+    const float hx = (samples[i].x - offset[0]) * k;
+    const float hy = (samples[i].y - offset[1]) * k;
+    const float hz = (samples[i].z - offset[2]) * k;
+    /* q = q * (1 - |h|^2 / 2, h), exact to second order */
+    const float c = 1.0F - 0.5F * (hx * hx + hy * hy + hz * hz);
+    const float nw = w * c - x * hx - y * hy - z * hz;
+    const float nx = x * c + w * hx + y * hz - z * hy;
+    const float ny = y * c + w * hy - x * hz + z * hx;
+    const float nz = z * c + w * hz + x * hy - y * hx;
+    w = nw;
+    x = nx;
+    y = ny;
+    z = nz;
+  }
+
+  const float norm = 1.0F / sqrtf(w * w + x * x + y * y + z * z);
+  _q[0] = w * norm;
+  _q[1] = x * norm;
+  _q[2] = y * norm;
+  _q[3] = z * norm;
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the orientation
+
+    @param  q   The placeholder for the unit quaternion w, x, y, z that
+                rotates body coordinates into the starting orientation.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_Attitude::getQuaternion(float *q) {
+  q[0] = _q[0];
+  q[1] = _q[1];
+  q[2] = _q[2];
+  q[3] = _q[3];
+}
+
+/** Fixed point one, 1.0 in Q30 */
+static const int32_t attitudeOne = (int32_t)1 << 30;
+
+/** Q30 half angle per mdps and microsecond, times 2^29: pi / 360e9 * 2^59 */
+static const int64_t attitudeHalfAngle = 5030569;
+
+/** Q30 product */
+static int32_t mulQ30(int32_t a, int32_t b) {
+  return (int32_t)(((int64_t)a * b) >> 30);
+}
+
+/**************************************************************************/
+/**
+    @brief  Instantiates a fixed point attitude integrator at the identity
+            orientation
+*/
+/**************************************************************************/
+Adafruit_L3GD20_AttitudeFixed::Adafruit_L3GD20_AttitudeFixed(void) {
+  reset();
+}
+
+/**************************************************************************/
+/**
+    @brief  Returns to the identity orientation; the next sample starts
+            the integration
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_AttitudeFixed::reset(void) {
+  _q[0] = attitudeOne;
+  _q[1] = 0;
+  _q[2] = 0;
+  _q[3] = 0;
+  _last = 0;
+  _started = false;
+}
+
+/**************************************************************************/
+/**
+    @brief  Rotates the orientation by a batch of samples
+
+    Same integration as Adafruit_L3GD20_Attitude, in Q30 with 64 bit
+    products. The rates use the exact sensitivities (8.75 = 35/4, 17.5 =
+    35/2 and 70 mdps/LSB) in quarter mdps.
+
+    @param  samples     The raw samples, oldest first, e.g. from
+                        readFifo().
+    @param  timestamps  The micros() time of each sample.
+    @param  count       The number of samples.
+    @param  range       The range the samples were taken at.
+    @param  bias        Optional mdps to subtract from each axis, e.g. from
+                        getBiasFixed(), or NULL.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_AttitudeFixed::update(const gyroRawData_t *samples,
+                                           const uint32_t *timestamps,
+                                           size_t count, gyroRange_t range,
+                                           const gyroFixedData_t *bias) {
+  const int32_t mul = (range == GYRO_RANGE_2000DPS)  ? 280
+                      : (range == GYRO_RANGE_500DPS) ? 70
+                                                     : 35;
+  int32_t offset[3] = {0, 0, 0};
+  int32_t w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+
+  if (bias != NULL) {
+    offset[0] = bias->x * 4;
+    offset[1] = bias->y * 4;
+    offset[2] = bias->z * 4;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t dt = timestamps[i] - _last;
+    _last = timestamps[i];
+    if (!_started || (dt > L3GD20_ATTITUDE_MAX_GAP)) {
+      /* Nothing to integrate over yet */
+      _started = true;
+      continue;
+    }
+
+    /* Half the rotation angle about each axis, in Q30 */
+    const int64_t k = (int64_t)dt * attitudeHalfAngle;
+    const int32_t hx = ((samples[i].x * mul - offset[0]) * k) >> 31;
+    const int32_t hy = ((samples[i].y * mul - offset[1]) * k) >> 31;
+    const int32_t hz = ((samples[i].z * mul - offset[2]) * k) >> 31;
+    /* q = q * (1 - |h|^2 / 2, h), exact to second order */
+    const int32_t c =
+        attitudeOne -
+        (int32_t)(((int64_t)hx * hx + (int64_t)hy * hy + (int64_t)hz * hz) >>
+                  31);
+    const int32_t nw =
+        mulQ30(w, c) - mulQ30(x, hx) - mulQ30(y, hy) - mulQ30(z, hz);
+    const int32_t nx =
+        mulQ30(x, c) + mulQ30(w, hx) + mulQ30(y, hz) - mulQ30(z, hy);
+    const int32_t ny =
+        mulQ30(y, c) + mulQ30(w, hy) - mulQ30(x, hz) + mulQ30(z, hx);
+    const int32_t nz =
+        mulQ30(z, c) + mulQ30(w, hz) + mulQ30(x, hy) - mulQ30(y, hx);
+    w = nw;
+    x = nx;
+    y = ny;
+    z = nz;
+  }
+
+  /* One Newton step towards unit norm, q *= (3 - |q|^2) / 2, enough
+     while the batch only moves the norm slightly */
+  int64_t squared =
+      ((int64_t)w * w + (int64_t)x * x + (int64_t)y * y + (int64_t)z * z) >>
+      30;
+  int32_t factor = (int32_t)((3 * (int64_t)attitudeOne - squared) >> 1);
+  _q[0] = mulQ30(w, factor);
+  _q[1] = mulQ30(x, factor);
+  _q[2] = mulQ30(y, factor);
+  _q[3] = mulQ30(z, factor);
+}
+
+/**************************************************************************/
+/**
+    @brief  Gets the orientation
+
+    @param  q   The placeholder for the unit quaternion w, x, y, z in Q30
+                (1 << 30 is 1.0), rotating body coordinates into the
+                starting orientation.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_AttitudeFixed::getQuaternion(int32_t *q) {
+  q[0] = _q[0];
+  q[1] = _q[1];
+  q[2] = _q[2];
+  q[3] = _q[3];
+}
+
+/***************************************************************************
+ BINARY STREAM
+ ***************************************************************************/
+
+/** Stream range code of a range. */
+static uint8_t streamRange(gyroRange_t range) {
+  switch (range) {
+  case GYRO_RANGE_2000DPS:
+    return 2;
+  case GYRO_RANGE_500DPS:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/** CRC-16/CCITT-FALSE, bitwise to stay small on AVR. */
+static uint16_t streamCrc(const uint8_t *p, size_t len) {
+  uint16_t crc = 0xFFFF;
+
+  while (len--) {
+    crc ^= (uint16_t)*p++ << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+/**************************************************************************/
+/**
+    @brief  Packs raw samples into one binary stream frame
+
+    Neighbouring samples differ little even during fast motion, so the
+    per-axis differences mostly fit one or two bytes instead of two plus
+    the text overhead.
+
+    @param  out         The buffer the frame is written to.
+    @param  size        The size of 'out'; L3GD20_STREAM_MAX_FRAME always
+                        fits.
+    @param  samples     The raw samples, oldest first, from getEvent()
+                        ('raw') or readFifo().
+    @param  timestamps  The micros() time of each sample.
+    @param  count       The number of samples, 1..L3GD20_STREAM_MAX_SAMPLES.
+    @param  range       The range the samples were taken at, from
+                        getRange().
+
+    @return The frame length in bytes, or 0 if 'count' is out of bounds
+            or the frame does not fit.
+*/
+/**************************************************************************/
+size_t l3gd20EncodeFrame(uint8_t *out, size_t size,
+                         const gyroRawData_t *samples,
+                         const uint32_t *timestamps, size_t count,
+                         gyroRange_t range) {
+  uint8_t payload[L3GD20_STREAM_MAX_PAYLOAD];
+  uint8_t *p = payload;
+  int32_t last[3] = {0, 0, 0};
+
+  if ((count == 0) || (count > L3GD20_STREAM_MAX_SAMPLES)) {
+    return 0;
+  }
+
+  p = putVarint(p, timestamps[count - 1] - timestamps[0]);
+  for (size_t i = 0; i < count; i++) {
+    const int32_t axis[3] = {samples[i].x, samples[i].y, samples[i].z};
+    for (uint8_t a = 0; a < 3; a++) {
+      /* Zigzag, so small negative differences stay small */
+      int32_t delta = axis[a] - last[a];
+      p = putVarint(p, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+      last[a] = axis[a];
+    }
+  }
+
+  const size_t length = p - payload;
+  const size_t total = L3GD20_STREAM_HEADER + length + 2;
+  if (total > size) {
+    return 0;
+  }
+
+  out[0] = L3GD20_STREAM_SYNC;
+  out[1] = (L3GD20_STREAM_VERSION << 4) | streamRange(range);
+  out[2] = count;
+  out[3] = length & 0xFF;
+  out[4] = length >> 8;
+  out[5] = timestamps[0] & 0xFF;
+  out[6] = (timestamps[0] >> 8) & 0xFF;
+  out[7] = (timestamps[0] >> 16) & 0xFF;
+  out[8] = timestamps[0] >> 24;
+  memcpy(out + L3GD20_STREAM_HEADER, payload, length);
+
+  const uint16_t crc = streamCrc(out + 1, L3GD20_STREAM_HEADER - 1 + length);
+  out[total - 2] = crc & 0xFF;
+  out[total - 1] = crc >> 8;
+
+  return total;
+}
+
+/**************************************************************************/
+/**
+    @brief  Instantiates a decoder waiting for the first frame
+*/
+/**************************************************************************/
+Adafruit_L3GD20_StreamDecoder::Adafruit_L3GD20_StreamDecoder(void) {
+  reset();
+}
+
+/**************************************************************************/
+/**
+    @brief  Drops any partial frame and clears the error count
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_StreamDecoder::reset(void) {
+  _len = 0;
+  count = 0;
+  range = GYRO_RANGE_250DPS;
+  errors = 0;
+}
+
+/**************************************************************************/
+/**
+    @brief  Adds one byte of the stream
+
+    Bytes outside a frame are skipped. After a bad frame the decoder
+    looks for the next sync byte inside it, so a corrupted frame does not
+    take the following one with it.
+
+    @param  byte    The next byte of the stream.
+
+    @return True when the byte completed a valid frame; its samples are
+            in 'samples', 'timestamps' and 'count' until the next one.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_StreamDecoder::feed(uint8_t byte) {
+  if ((_len == 0) && (byte != L3GD20_STREAM_SYNC)) {
+    return false;
+  }
+  _buf[_len++] = byte;
+  return check();
+}
+
+/**************************************************************************/
+/**
+    @brief  Validates the buffered bytes as far as they go
+
+    @return True if they hold a complete, valid frame.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_StreamDecoder::check(void) {
+  while (_len >= 5) {
+    const uint16_t length = _buf[3] | (_buf[4] << 8);
+    if (((_buf[1] >> 4) != L3GD20_STREAM_VERSION) ||
+        ((_buf[1] & 0x0F) > 2) || (_buf[2] == 0) ||
+        (_buf[2] > L3GD20_STREAM_MAX_SAMPLES) ||
+        (length > L3GD20_STREAM_MAX_PAYLOAD)) {
+      resync();
+      continue;
+    }
+
+    const uint16_t total = L3GD20_STREAM_HEADER + length + 2;
+    if (_len < total) {
+      return false;
+    }
+    const uint16_t crc = _buf[total - 2] | (_buf[total - 1] << 8);
+    if ((streamCrc(_buf + 1, total - 3) != crc) || !parse()) {
+      resync();
+      continue;
+    }
+
+    /* Keep whatever followed the frame */
+    _len -= total;
+    memmove(_buf, _buf + total, _len);
+    return true;
+  }
+  return false;
+}
+
+/**************************************************************************/
+/**
+    @brief  Unpacks the buffered frame, whose CRC has been checked
+
+    @return True if the payload matched the header.
+*/
+/**************************************************************************/
+bool Adafruit_L3GD20_StreamDecoder::parse(void) {
+  const uint8_t n = _buf[2];
+  const uint16_t length = _buf[3] | (_buf[4] << 8);
+  const uint8_t *p = _buf + L3GD20_STREAM_HEADER;
+  const uint8_t *end = p + length;
+  gyroRawData_t decoded[L3GD20_STREAM_MAX_SAMPLES];
+  int32_t last[3] = {0, 0, 0};
+  uint32_t span;
+
+  p = getVarint(p, end, &span);
+  for (uint8_t i = 0; (i < n) && (p != NULL); i++) {
+    for (uint8_t a = 0; (a < 3) && (p != NULL); a++) {
+      uint32_t zigzag;
+      p = getVarint(p, end, &zigzag);
+      last[a] += (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+    }
+    decoded[i].x = (int16_t)last[0];
+    decoded[i].y = (int16_t)last[1];
+    decoded[i].z = (int16_t)last[2];
+  }
+  if (p != end) {
+    return false;
+  }
+
+  const uint32_t t0 = (uint32_t)_buf[5] | ((uint32_t)_buf[6] << 8) |
+                      ((uint32_t)_buf[7] << 16) | ((uint32_t)_buf[8] << 24);
+  for (uint8_t i = 0; i < n; i++) {
+    samples[i] = decoded[i];
+    timestamps[i] =
+        t0 + ((n > 1) ? (uint32_t)(((uint64_t)span * i + (n - 1) / 2) /
+                                   (n - 1))
+                      : 0);
+  }
+  count = n;
+  switch (_buf[1] & 0x0F) {
+  case 2:
+    range = GYRO_RANGE_2000DPS;
+    break;
+  case 1:
+    range = GYRO_RANGE_500DPS;
+    break;
+  default:
+    range = GYRO_RANGE_250DPS;
+    break;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/**
+    @brief  Drops the buffered frame start and restarts at the next sync
+            byte inside it
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_StreamDecoder::resync(void) {
+  uint16_t next = 1;
+
+  errors++;
+  while ((next < _len) && (_buf[next] != L3GD20_STREAM_SYNC)) {
+    next++;
+  }
+  _len -= next;
+  memmove(_buf, _buf + next, _len);
+}
+
+/**************************************************************************/
+/**
+    @brief  Converts the samples of the last frame to rad/s
+
+    @param  out     The placeholder for 'count' x, y, z triplets.
+*/
+/**************************************************************************/
+void Adafruit_L3GD20_StreamDecoder::convertSamples(float *out) {
+  const float scale = (range == GYRO_RANGE_2000DPS)  ? GYRO_SCALE_2000DPS
+                      : (range == GYRO_RANGE_500DPS) ? GYRO_SCALE_500DPS
+                                                     : GYRO_SCALE_250DPS;
+
+  for (uint8_t i = 0; i < count; i++) {
+    out[3 * i] = samples[i].x * scale;
+    out[3 * i + 1] = samples[i].y * scale;
+    out[3 * i + 2] = samples[i].z * scale;
+  }
+}
+
+/***************************************************************************
+ BUS CAPTURE
+ ***************************************************************************/
+
+/**************************************************************************/
+/**
+    @brief  Parses one bus capture record
+
+    @param  buf     The capture, starting at a record.
+    @param  size    The bytes available in 'buf'.
+    @param  record  The placeholder for the parsed record; its data points
+                    into 'buf'.
+
+    @return The length of the record, or 0 if 'buf' does not hold a
+            complete, valid one.
+*/
+/**************************************************************************/
+size_t l3gd20ParseCapture(const uint8_t *buf, size_t size,
+                          gyroBusRecord_t *record) {
+  const uint8_t *end = buf + size;
+  const uint8_t *p = buf;
+
+  if (size == 0) {
+    return 0;
+  }
+  const uint8_t op = *p++;
+  if (((op & 0x7F) < GYRO_BUS_READ8) || ((op & 0x7F) > GYRO_BUS_DRAIN)) {
+    return 0;
+  }
+  record->op = (gyroBusOp_t)(op & 0x7F);
+  record->ok = !(op & 0x80);
+  if (((p = getVarint(p, end, &record->gap)) == NULL) ||
+      ((p = getVarint(p, end, &record->duration)) == NULL) ||
+      (end - p < 2)) {
+    return 0;
+  }
+  record->reg = *p++;
+  record->length = *p++;
+  if (end - p < record->length) {
+    return 0;
+  }
+  record->data = p;
+
+  return (p + record->length) - buf;
 }
 
 /* --- The code below is no longer maintained and provided solely for */
@@ -418,6 +3671,7 @@ void Adafruit_L3GD20_Unified::getSensor(sensor_t *sensor) {
 /// @private
 Adafruit_L3GD20::Adafruit_L3GD20(int8_t cs, int8_t miso, int8_t mosi,
                                  int8_t clk) {
+  _i2c = &Wire;
   _cs = cs;
   _miso = miso;
   _mosi = mosi;
@@ -427,6 +3681,7 @@ Adafruit_L3GD20::Adafruit_L3GD20(int8_t cs, int8_t miso, int8_t mosi,
 /// @private
 Adafruit_L3GD20::Adafruit_L3GD20(void) {
   // use i2c
+  _i2c = &Wire;
   _cs = _mosi = _miso = _clk = -1;
 }
 
@@ -12,19 +12,77 @@
 #endif
 
 #include <Adafruit_Sensor.h>
+#include <SPI.h>
 #include <Wire.h>
 
 /*=========================================================================
     I2C ADDRESS/BITS AND SETTINGS
     -----------------------------------------------------------------------*/
-#define L3GD20_ADDRESS (0x6B)     //!< L3gD20 I2C address; 1101011 in binary
-#define L3GD20_POLL_TIMEOUT (100) //!< Maximum number of read attempts
-#define L3GD20_ID (0xD4)          //!< L3GD20 ID
-#define L3GD20H_ID (0xD7)         //!< L3GD20H ID
+#define L3GD20_ADDRESS (0x6B)        //!< L3gD20 I2C address; 1101011 in binary
+#define L3GD20_ADDRESS_ALT (0x6A)    //!< I2C address with SDO pulled low
+#define L3GD20_POLL_TIMEOUT (100)    //!< Maximum number of read attempts
+#define L3GD20_ASYNC_RETRIES (3)     //!< Default startRead() retry budget
+#define L3GD20_ASYNC_TIMEOUT_MS (10) //!< Default startRead() timeout in ms
+#define L3GD20_ID (0xD4)             //!< L3GD20 ID
+#define L3GD20H_ID (0xD7)            //!< L3GD20H ID
+#define L3GD20_FIFO_SIZE (32)        //!< Samples held by the hardware FIFO
+#define L3GD20_SHADOW_SIZE (26)      //!< Cached registers, 0x20..0x39
 // Sesitivity values from the mechanical characteristics in the datasheet.
 #define GYRO_SENSITIVITY_250DPS (0.00875F) //!< Sensitivity at 250 dps
 #define GYRO_SENSITIVITY_500DPS (0.0175F)  //!< Sensitivity at 500 dps
 #define GYRO_SENSITIVITY_2000DPS (0.070F)  //!< Sensitivity at 2000 dps
+/** Raw to rad/s factor at 250 dps (sensitivity and unit conversion fused) */
+#define GYRO_SCALE_250DPS (GYRO_SENSITIVITY_250DPS * SENSORS_DPS_TO_RADS)
+/** Raw to rad/s factor at 500 dps (sensitivity and unit conversion fused) */
+#define GYRO_SCALE_500DPS (GYRO_SENSITIVITY_500DPS * SENSORS_DPS_TO_RADS)
+/** Raw to rad/s factor at 2000 dps (sensitivity and unit conversion fused) */
+#define GYRO_SCALE_2000DPS (GYRO_SENSITIVITY_2000DPS * SENSORS_DPS_TO_RADS)
+#if defined(I2C_BUFFER_LENGTH)
+#define L3GD20_I2C_BUFFER_SIZE (I2C_BUFFER_LENGTH) //!< Wire RX buffer size
+#elif defined(BUFFER_LENGTH)
+#define L3GD20_I2C_BUFFER_SIZE (BUFFER_LENGTH) //!< Wire RX buffer size
+#else
+#define L3GD20_I2C_BUFFER_SIZE (32) //!< Wire RX buffer size
+#endif
+/** Maximum SPI clock the sensor supports */
+#define L3GD20_SPI_FREQUENCY (10000000)
+/** Auto-range steps down below this percentage of the narrower range */
+#define L3GD20_RANGE_DOWN_PERCENT (75)
+/** Consecutive quiet samples before auto-range steps down */
+#define L3GD20_RANGE_DOWN_SAMPLES (50)
+/** Largest deviation from the running mean, in mdps, while still */
+#define L3GD20_STILL_THRESHOLD (2000)
+/** Consecutive still samples that make one bias estimate */
+#define L3GD20_STILL_SAMPLES (128)
+/** Largest bias, in mdps, accepted as an estimate */
+#define L3GD20_BIAS_LIMIT (15000)
+/** Temperature bins of the bias table */
+#define L3GD20_BIAS_BINS (8)
+/** Width of a bias table bin in OUT_TEMP LSB (about 1 degree C each) */
+#define L3GD20_BIAS_BIN_WIDTH (8)
+/** Milliseconds between OUT_TEMP reads while draining the FIFO */
+#define L3GD20_TEMP_INTERVAL_MS (1000)
+/** Longest gap between two samples the attitude integrators bridge, in us */
+#define L3GD20_ATTITUDE_MAX_GAP (100000)
+/** Samples discarded after leaving sleep mode, in us of sensor time */
+#define L3GD20_SLEEP_WAKE_US (5000)
+/** Samples discarded after leaving power-down mode, in us of sensor time */
+#define L3GD20_POWERDOWN_WAKE_US (250000)
+/** First byte of every binary stream frame */
+#define L3GD20_STREAM_SYNC (0xA5)
+/** Format version in the upper nibble of the frame flags */
+#define L3GD20_STREAM_VERSION (1)
+/** Most samples in one binary stream frame */
+#define L3GD20_STREAM_MAX_SAMPLES (32)
+/** Fixed part of a frame: sync, flags, count, length and first timestamp */
+#define L3GD20_STREAM_HEADER (9)
+/** Largest frame payload: a 5 byte time span and 3 bytes per axis */
+#define L3GD20_STREAM_MAX_PAYLOAD (5 + 9 * L3GD20_STREAM_MAX_SAMPLES)
+/** Largest frame, header, payload and CRC included */
+#define L3GD20_STREAM_MAX_FRAME                                                \
+  (L3GD20_STREAM_HEADER + L3GD20_STREAM_MAX_PAYLOAD + 2)
+/** Largest bus capture record: a full FIFO drain */
+#define L3GD20_CAPTURE_MAX_RECORD (13 + 6 * L3GD20_FIFO_SIZE)
 /*=========================================================================*/
 
 /*!
@@ -56,9 +114,18 @@ typedef enum {                        // DEFAULT    TYPE
   GYRO_REGISTER_TSH_YL = 0x35,        // 00000000   rw
   GYRO_REGISTER_TSH_ZH = 0x36,        // 00000000   rw
   GYRO_REGISTER_TSH_ZL = 0x37,        // 00000000   rw
-  GYRO_REGISTER_INT1_DURATION = 0x38  // 00000000   rw
+  GYRO_REGISTER_INT1_DURATION = 0x38, // 00000000   rw
+  GYRO_REGISTER_LOW_ODR = 0x39        // 00000000   rw   L3GD20H only
 } gyroRegisters_t;
 
+/*!
+ * @brief Chip variants, by WHO_AM_I value
+ */
+typedef enum {
+  GYRO_VARIANT_L3GD20 = L3GD20_ID,  //!< Original L3GD20
+  GYRO_VARIANT_L3GD20H = L3GD20H_ID //!< L3GD20H: faster rates, LOW_ODR
+} gyroVariant_t;
+
 /*!
  * @brief Optional speed settings
  */
@@ -68,6 +135,176 @@ typedef enum {
   GYRO_RANGE_2000DPS = 2000
 } gyroRange_t;
 
+/*!
+ * @brief Axes to measure, combinable as flags (ZEN, YEN and XEN bits of
+ * CTRL_REG1)
+ */
+typedef enum {
+  GYRO_AXIS_X = 0x01,  //!< Pitch or roll, depending on mounting
+  GYRO_AXIS_Y = 0x02,  //!< Pitch or roll, depending on mounting
+  GYRO_AXIS_Z = 0x04,  //!< Yaw when mounted flat
+  GYRO_AXIS_ALL = 0x07 //!< All three axes, the default
+} gyroAxes_t;
+
+/*!
+ * @brief Power modes (PD and axis enable bits of CTRL_REG1)
+ */
+typedef enum {
+  GYRO_POWER_NORMAL, //!< Measuring the axes set with setAxes()
+  GYRO_POWER_SLEEP,  //!< Drive kept running, no output; wakes quickly
+  GYRO_POWER_DOWN    //!< Everything off; wakes slowly
+} gyroPowerMode_t;
+
+/*!
+ * @brief States of the duty-cycled acquisition
+ */
+typedef enum {
+  GYRO_DUTY_OFF,       //!< Not duty cycling
+  GYRO_DUTY_IDLE,      //!< Asleep or powered down until the next batch
+  GYRO_DUTY_WAKING,    //!< Awake, waiting for the output to settle
+  GYRO_DUTY_COLLECTING //!< Filling the FIFO with the batch
+} gyroDutyState_t;
+
+/*!
+ * @brief Output data rates (DR1..0 bits of CTRL_REG1, and Low_ODR of
+ * LOW_ODR on the L3GD20H)
+ *
+ * The L3GD20H runs the four DR1..0 settings at 100, 200, 400 and 800 Hz.
+ * The rates from 12.5 to 50 Hz are L3GD20H only; the L3GD20 runs at 95 Hz
+ * instead.
+ */
+typedef enum {
+  GYRO_DATARATE_95HZ = 0,   //!< 95 Hz output data rate
+  GYRO_DATARATE_190HZ = 1,  //!< 190 Hz output data rate
+  GYRO_DATARATE_380HZ = 2,  //!< 380 Hz output data rate
+  GYRO_DATARATE_760HZ = 3,  //!< 760 Hz output data rate
+  GYRO_DATARATE_100HZ = 0,  //!< 100 Hz on the L3GD20H, 95 Hz on the L3GD20
+  GYRO_DATARATE_200HZ = 1,  //!< 200 Hz on the L3GD20H, 190 Hz on the L3GD20
+  GYRO_DATARATE_400HZ = 2,  //!< 400 Hz on the L3GD20H, 380 Hz on the L3GD20
+  GYRO_DATARATE_800HZ = 3,  //!< 800 Hz on the L3GD20H, 760 Hz on the L3GD20
+  GYRO_DATARATE_12_5HZ = 4, //!< 12.5 Hz output data rate (L3GD20H)
+  GYRO_DATARATE_25HZ = 5,   //!< 25 Hz output data rate (L3GD20H)
+  GYRO_DATARATE_50HZ = 6    //!< 50 Hz output data rate (L3GD20H)
+} gyroDataRate_t;
+
+/*!
+ * @brief Low-pass cutoff selection (BW1..0 bits of CTRL_REG1)
+ *
+ * The cutoff frequency depends on the output data rate:
+ *
+ *   Data rate   BANDWIDTH_0  BANDWIDTH_1  BANDWIDTH_2  BANDWIDTH_3
+ *   ---------   -----------  -----------  -----------  -----------
+ *      95 Hz       12.5 Hz        25 Hz        25 Hz        25 Hz
+ *     190 Hz       12.5 Hz        25 Hz        50 Hz        70 Hz
+ *     380 Hz         20 Hz        25 Hz        50 Hz       100 Hz
+ *     760 Hz         30 Hz        35 Hz        50 Hz       100 Hz
+ *
+ * The L3GD20H cutoffs differ, see its datasheet. Below 100 Hz it has a
+ * single cutoff per rate.
+ */
+typedef enum {
+  GYRO_BANDWIDTH_0 = 0, //!< Lowest cutoff for the selected data rate
+  GYRO_BANDWIDTH_1 = 1, //!< Second lowest cutoff
+  GYRO_BANDWIDTH_2 = 2, //!< Second highest cutoff
+  GYRO_BANDWIDTH_3 = 3  //!< Highest cutoff for the selected data rate
+} gyroBandwidth_t;
+
+/*!
+ * @brief High-pass filter modes (HPM1..0 bits of CTRL_REG2)
+ */
+typedef enum {
+  GYRO_HIGHPASS_NORMAL_RESET = 0x00, //!< Normal, reset by resetHighPass()
+  GYRO_HIGHPASS_REFERENCE = 0x10,    //!< Output minus the REFERENCE value
+  GYRO_HIGHPASS_NORMAL = 0x20,       //!< Normal mode
+  GYRO_HIGHPASS_AUTORESET = 0x30     //!< Reset on each INT1 event
+} gyroHighPassMode_t;
+
+/*!
+ * @brief High-pass cutoff selection (HPCF3..0 bits of CTRL_REG2)
+ *
+ * The cutoff frequency in Hz depends on the output data rate:
+ *
+ *   Cutoff      95 Hz    190 Hz    380 Hz    760 Hz
+ *   ------    -------   -------   -------   -------
+ *      0          7.2      13.5        27      51.4
+ *      1          3.5       7.2      13.5        27
+ *      2          1.8       3.5       7.2      13.5
+ *      3          0.9       1.8       3.5       7.2
+ *      4         0.45       0.9       1.8       3.5
+ *      5         0.18      0.45       0.9       1.8
+ *      6         0.09      0.18      0.45       0.9
+ *      7        0.045      0.09      0.18      0.45
+ *      8        0.018     0.045      0.09      0.18
+ *      9        0.009     0.018     0.045      0.09
+ */
+typedef enum {
+  GYRO_HIGHPASS_CUTOFF_0 = 0, //!< Highest cutoff for the selected data rate
+  GYRO_HIGHPASS_CUTOFF_1 = 1, //!< About half of GYRO_HIGHPASS_CUTOFF_0
+  GYRO_HIGHPASS_CUTOFF_2 = 2, //!< About a quarter of GYRO_HIGHPASS_CUTOFF_0
+  GYRO_HIGHPASS_CUTOFF_3 = 3, //!< About 1/8 of GYRO_HIGHPASS_CUTOFF_0
+  GYRO_HIGHPASS_CUTOFF_4 = 4, //!< About 1/16 of GYRO_HIGHPASS_CUTOFF_0
+  GYRO_HIGHPASS_CUTOFF_5 = 5, //!< About 1/40 of GYRO_HIGHPASS_CUTOFF_0
+  GYRO_HIGHPASS_CUTOFF_6 = 6, //!< About 1/80 of GYRO_HIGHPASS_CUTOFF_0
+  GYRO_HIGHPASS_CUTOFF_7 = 7, //!< About 1/160 of GYRO_HIGHPASS_CUTOFF_0
+  GYRO_HIGHPASS_CUTOFF_8 = 8, //!< About 1/400 of GYRO_HIGHPASS_CUTOFF_0
+  GYRO_HIGHPASS_CUTOFF_9 = 9  //!< Lowest cutoff for the selected data rate
+} gyroHighPassCutoff_t;
+
+/*!
+ * @brief Filters the output registers and the FIFO are fed from (HPen and
+ * OUT_SEL1..0 bits of CTRL_REG5)
+ *
+ * Every path starts with the fixed low-pass filter LPF1. The bandwidth
+ * set with setDataRate() is the cutoff of LPF2, which only applies on the
+ * paths that include it.
+ */
+typedef enum {
+  GYRO_FILTER_LPF1 = 0x00,    //!< LPF1 only, the power-on default
+  GYRO_FILTER_HPF = 0x11,     //!< LPF1 and the high-pass filter
+  GYRO_FILTER_LPF2 = 0x02,    //!< LPF1 and LPF2
+  GYRO_FILTER_HPF_LPF2 = 0x12 //!< LPF1, the high-pass filter and LPF2
+} gyroFilterPath_t;
+
+/*!
+ * @brief FIFO operating modes (FM2..0 bits of FIFO_CTRL_REG)
+ *
+ * Dynamic stream and bypass-to-FIFO are L3GD20H only.
+ */
+typedef enum {
+  GYRO_FIFO_BYPASS = 0x00,           //!< FIFO disabled, output registers only
+  GYRO_FIFO_FIFO = 0x20,             //!< Collect until full, then stop
+  GYRO_FIFO_STREAM = 0x40,           //!< Collect continuously, drop oldest
+  GYRO_FIFO_STREAM_TO_FIFO = 0x60,   //!< Stream until INT1 event, then FIFO
+  GYRO_FIFO_BYPASS_TO_STREAM = 0x80, //!< Bypass until INT1 event, then stream
+  GYRO_FIFO_DYNAMIC_STREAM = 0xC0,   //!< Stream, each drain sees new samples
+  GYRO_FIFO_BYPASS_TO_FIFO = 0xE0    //!< Bypass until INT1 event, then FIFO
+} gyroFifoMode_t;
+
+/*!
+ * @brief Threshold events of the INT1 generator, combinable as flags (bits
+ * of INT1_CFG and INT1_SRC)
+ */
+typedef enum {
+  GYRO_MOTION_X_LOW = 0x01,   //!< X rate magnitude below its threshold
+  GYRO_MOTION_X_HIGH = 0x02,  //!< X rate magnitude above its threshold
+  GYRO_MOTION_Y_LOW = 0x04,   //!< Y rate magnitude below its threshold
+  GYRO_MOTION_Y_HIGH = 0x08,  //!< Y rate magnitude above its threshold
+  GYRO_MOTION_Z_LOW = 0x10,   //!< Z rate magnitude below its threshold
+  GYRO_MOTION_Z_HIGH = 0x20,  //!< Z rate magnitude above its threshold
+  GYRO_MOTION_ANY_HIGH = 0x2A //!< Any axis above its threshold
+} gyroMotionEvent_t;
+
+/*!
+ * @brief States of the non-blocking reader
+ */
+typedef enum {
+  GYRO_READ_IDLE,  //!< No read started
+  GYRO_READ_BUSY,  //!< Read in progress, keep calling pollRead()
+  GYRO_READ_DONE,  //!< Sample ready, collect it with completeRead()
+  GYRO_READ_ERROR, //!< Retry budget or timeout exhausted
+  GYRO_READ_STALE  //!< No new sample since the last read (status reads)
+} gyroReadStatus_t;
+
 /*=========================================================================
     RAW GYROSCOPE DATA TYPE
     -----------------------------------------------------------------------*/
@@ -80,29 +317,1263 @@ typedef struct gyroRawData_s {
   /** The Z axis data. */
   int16_t z;
 } gyroRawData_t;
+
+/** Encapsulates a single sample in integer millidegrees per second. */
+typedef struct gyroFixedData_s {
+  /** The X axis rate in mdps. */
+  int32_t x;
+  /** The Y axis rate in mdps. */
+  int32_t y;
+  /** The Z axis rate in mdps. */
+  int32_t z;
+} gyroFixedData_t;
+
+/** Zero-rate bias per temperature bin, as learned by the driver. Can be
+    saved and restored to skip learning after a reset. */
+typedef struct gyroBiasTable_s {
+  /** Bias of each bin, in 1/16 LSB at 250 dps. */
+  int16_t bias[L3GD20_BIAS_BINS][3];
+  /** OUT_TEMP value at the start of bin 0. */
+  int8_t baseTemperature;
+  /** Bit n is set if bin n holds an estimate. */
+  uint8_t valid;
+} gyroBiasTable_t;
 /*=========================================================================*/
 
+/*=========================================================================
+    BUS CAPTURE
+    -----------------------------------------------------------------------
+    One record per bus transaction of Adafruit_L3GD20_Unified, in the
+    order the driver made them:
+
+      op                 'gyroBusOp_t', bit 7 set if the bus failed
+      gap                varint, us from the end of the previous
+                         transaction (or from setBusCapture()) to the
+                         start of this one
+      duration           varint, us the transaction took
+      reg                register addressed
+      length             bytes that follow
+      data               bytes read or written; FIFO drains hold 6
+                         bytes per sample, X, Y and Z little-endian
+
+    Records stand alone and are written back to back, so a capture file
+    is simply their concatenation.
+    -----------------------------------------------------------------------*/
+/*!
+ * @brief Bus transactions in a capture record
+ */
+typedef enum {
+  GYRO_BUS_READ8 = 1,   //!< Single register read
+  GYRO_BUS_WRITE = 2,   //!< Auto-increment register write
+  GYRO_BUS_SELECT = 3,  //!< Address phase of a burst read
+  GYRO_BUS_RECEIVE = 4, //!< Data phase of a burst read
+  GYRO_BUS_DRAIN = 5    //!< FIFO drain of one or more samples
+} gyroBusOp_t;
+
+/** One bus transaction, as parsed by l3gd20ParseCapture(). */
+typedef struct gyroBusRecord_s {
+  /** The kind of transaction. */
+  gyroBusOp_t op;
+  /** False if the bus failed. */
+  bool ok;
+  /** us from the end of the previous transaction to the start of this. */
+  uint32_t gap;
+  /** us the transaction took. */
+  uint32_t duration;
+  /** Register addressed. */
+  uint8_t reg;
+  /** Bytes in 'data'. */
+  uint8_t length;
+  /** Bytes read or written, pointing into the parsed buffer. */
+  const uint8_t *data;
+} gyroBusRecord_t;
+
+/** Receives the capture as it is made, e.g. to write it to a file. A
+    record can arrive in several pieces, to be appended in order. */
+typedef void (*l3gd20CaptureFunc_t)(const uint8_t *record, uint8_t length,
+                                    void *context);
+
+/** Answers a bus transaction from a capture instead of the bus. 'length'
+    holds the bytes requested or written and receives the bytes replayed;
+    read data goes to 'data'. Returns false for a failed transaction. */
+typedef bool (*l3gd20ReplayFunc_t)(gyroBusOp_t op, uint8_t reg,
+                                   uint8_t *data, uint8_t *length,
+                                   void *context);
+
+size_t l3gd20ParseCapture(const uint8_t *buf, size_t size,
+                          gyroBusRecord_t *record);
+
+/*=========================================================================
+    BUS TRANSPORTS
+    -----------------------------------------------------------------------
+    Every transport implements the same small inline interface, so
+    Adafruit_L3GD20_Core<Bus> compiles down to exactly one bus path:
+
+      void begin(void);
+      void write8(uint8_t reg, uint8_t value);
+      uint8_t read8(uint8_t reg);
+      bool writeBytes(uint8_t reg, const uint8_t *buf, uint8_t len);
+      bool select(uint8_t reg);                 address phase of a read
+      bool receive(uint8_t *buf, uint8_t len);  data phase of a read
+      bool readBytes(uint8_t reg, uint8_t *buf, uint8_t len);
+      void beginBurst(uint8_t reg);             start a long read, e.g.
+      bool burst(uint8_t *buf, uint8_t len);    a FIFO drain, that may span
+      void endBurst(void);                      several receive buffers
+
+    Bursts must not exceed L3GD20_I2C_BUFFER_SIZE bytes per call.
+    -----------------------------------------------------------------------*/
+#if defined(__AVR__)
+#define L3GD20_FAST_PINIO                 //!< Port I/O for bit-bang SPI
+typedef volatile uint8_t l3gd20PortReg_t; //!< GPIO port register
+typedef uint8_t l3gd20PortMask_t;         //!< Pin mask within a port
+#elif defined(ARDUINO_ARCH_SAMD)
+#define L3GD20_FAST_PINIO                  //!< Port I/O for bit-bang SPI
+typedef volatile uint32_t l3gd20PortReg_t; //!< GPIO port register
+typedef uint32_t l3gd20PortMask_t;         //!< Pin mask within a port
+#endif
+
+/**
+ * I2C transport on a given TwoWire bus.
+ */
+class Adafruit_L3GD20_I2C {
+public:
+  /**
+   * @param theWire The I2C bus the sensor is connected to.
+   * @param addr    L3GD20_ADDRESS (SDO high) or L3GD20_ADDRESS_ALT (SDO low).
+   */
+  Adafruit_L3GD20_I2C(TwoWire *theWire = &Wire, uint8_t addr = L3GD20_ADDRESS)
+      : _wire(theWire), _address(addr), _burstRegister(0) {}
+
+  /** Enables the I2C bus. */
+  void begin(void) { _wire->begin(); }
+
+  /**
+   * Writes a single register.
+   * @param reg   The register to write to.
+   * @param value The value to assign to 'reg'.
+   */
+  void write8(uint8_t reg, uint8_t value) {
+    _wire->beginTransmission(_address);
+#if ARDUINO >= 100
+    _wire->write(reg);
+    _wire->write(value);
+#else
+    _wire->send(reg);
+    _wire->send(value);
+#endif
+    _wire->endTransmission();
+  }
+
+  /**
+   * Writes consecutive registers in one auto-increment transaction.
+   * @param reg The first register to write to.
+   * @param buf The values to write.
+   * @param len The number of registers to write.
+   * @return True if the sensor acknowledged, otherwise false.
+   */
+  bool writeBytes(uint8_t reg, const uint8_t *buf, uint8_t len) {
+    _wire->beginTransmission(_address);
+#if ARDUINO >= 100
+    _wire->write((uint8_t)(reg | 0x80));
+    _wire->write(buf, len);
+#else
+    _wire->send(reg | 0x80);
+    _wire->send((uint8_t *)buf, len);
+#endif
+    return _wire->endTransmission() == 0;
+  }
+
+  /**
+   * Reads a single register.
+   * @param reg The register to read.
+   * @return The value read from 'reg'.
+   */
+  uint8_t read8(uint8_t reg) {
+    _wire->beginTransmission(_address);
+#if ARDUINO >= 100
+    _wire->write(reg);
+#else
+    _wire->send(reg);
+#endif
+    _wire->endTransmission();
+    _wire->requestFrom(_address, (uint8_t)1);
+#if ARDUINO >= 100
+    return _wire->read();
+#else
+    return _wire->receive();
+#endif
+  }
+
+  /**
+   * Sets the register pointer for a following auto-increment read.
+   * @param reg The first register to read.
+   * @return True if the sensor acknowledged, otherwise false.
+   */
+  bool select(uint8_t reg) {
+    _wire->beginTransmission(_address);
+#if ARDUINO >= 100
+    _wire->write((uint8_t)(reg | 0x80));
+#else
+    _wire->send(reg | 0x80);
+#endif
+    return _wire->endTransmission() == 0;
+  }
+
+  /**
+   * Reads bytes starting at the register set by select().
+   * @param buf The placeholder where the register values are written.
+   * @param len The number of bytes to read.
+   * @return True if all bytes were read, otherwise false.
+   */
+  bool receive(uint8_t *buf, uint8_t len) {
+    if (_wire->requestFrom(_address, len) != len) {
+      return false;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+#if ARDUINO >= 100
+      buf[i] = _wire->read();
+#else
+      buf[i] = _wire->receive();
+#endif
+    }
+    return true;
+  }
+
+  /**
+   * Reads a block of consecutive registers.
+   * @param reg The first register to read.
+   * @param buf The placeholder where the register values are written.
+   * @param len The number of bytes to read.
+   * @return True if all bytes were read, otherwise false.
+   */
+  bool readBytes(uint8_t reg, uint8_t *buf, uint8_t len) {
+    return select(reg) && receive(buf, len);
+  }
+
+  /**
+   * Starts a long read. Each burst() is its own transaction from 'reg'.
+   * @param reg The register every burst starts at.
+   */
+  void beginBurst(uint8_t reg) { _burstRegister = reg; }
+
+  /**
+   * Reads the next part of a long read.
+   * @param buf The placeholder where the register values are written.
+   * @param len The number of bytes to read.
+   * @return True if all bytes were read, otherwise false.
+   */
+  bool burst(uint8_t *buf, uint8_t len) {
+    return readBytes(_burstRegister, buf, len);
+  }
+
+  /** Ends a long read. */
+  void endBurst(void) {}
+
+private:
+  TwoWire *_wire;
+  uint8_t _address;
+  uint8_t _burstRegister;
+};
+
+/**
+ * Hardware SPI transport (mode 3, up to L3GD20_SPI_FREQUENCY).
+ */
+class Adafruit_L3GD20_SPI {
+public:
+  /**
+   * @param cs     The chip select pin.
+   * @param theSPI The SPI bus the sensor is connected to.
+   */
+  Adafruit_L3GD20_SPI(int8_t cs = -1, SPIClass *theSPI = &SPI)
+      : _spi(theSPI), _cs(cs), _register(0) {}
+
+  /** Releases chip select and enables the SPI bus. */
+  void begin(void) {
+    pinMode(_cs, OUTPUT);
+    digitalWrite(_cs, HIGH);
+    _spi->begin();
+  }
+
+  /**
+   * Writes a single register.
+   * @param reg   The register to write to.
+   * @param value The value to assign to 'reg'.
+   */
+  void write8(uint8_t reg, uint8_t value) {
+    frameBegin();
+    _spi->transfer(reg & 0x3F);
+    _spi->transfer(value);
+    frameEnd();
+  }
+
+  /**
+   * Writes consecutive registers in one auto-increment frame.
+   * @param reg The first register to write to.
+   * @param buf The values to write.
+   * @param len The number of registers to write.
+   * @return Always true, SPI has no acknowledge.
+   */
+  bool writeBytes(uint8_t reg, const uint8_t *buf, uint8_t len) {
+    frameBegin();
+    _spi->transfer((reg & 0x3F) | 0x40); // WRITE, auto-increment
+    for (uint8_t i = 0; i < len; i++) {
+      _spi->transfer(buf[i]);
+    }
+    frameEnd();
+    return true;
+  }
+
+  /**
+   * Reads a single register.
+   * @param reg The register to read.
+   * @return The value read from 'reg'.
+   */
+  uint8_t read8(uint8_t reg) {
+    frameBegin();
+    _spi->transfer((reg & 0x3F) | 0x80); // set READ bit
+    uint8_t value = _spi->transfer(0x00);
+    frameEnd();
+    return value;
+  }
+
+  /**
+   * Remembers the first register of a following receive(); over SPI the
+   * address is sent in the same frame as the data.
+   * @param reg The first register to read.
+   * @return Always true.
+   */
+  bool select(uint8_t reg) {
+    _register = reg;
+    return true;
+  }
+
+  /**
+   * Reads bytes starting at the register set by select().
+   * @param buf The placeholder where the register values are written.
+   * @param len The number of bytes to read.
+   * @return Always true, SPI has no acknowledge.
+   */
+  bool receive(uint8_t *buf, uint8_t len) {
+    beginBurst(_register);
+    burst(buf, len);
+    endBurst();
+    return true;
+  }
+
+  /**
+   * Reads a block of consecutive registers.
+   * @param reg The first register to read.
+   * @param buf The placeholder where the register values are written.
+   * @param len The number of bytes to read.
+   * @return Always true, SPI has no acknowledge.
+   */
+  bool readBytes(uint8_t reg, uint8_t *buf, uint8_t len) {
+    select(reg);
+    return receive(buf, len);
+  }
+
+  /**
+   * Starts a long read as a single chip-select frame.
+   * @param reg The first register to read.
+   */
+  void beginBurst(uint8_t reg) {
+    frameBegin();
+    _spi->transfer((reg & 0x3F) | 0xC0); // READ, auto-increment
+  }
+
+  /**
+   * Clocks out the next part of a long read.
+   * @param buf The placeholder where the register values are written.
+   * @param len The number of bytes to read.
+   * @return Always true, SPI has no acknowledge.
+   */
+  bool burst(uint8_t *buf, uint8_t len) {
+    memset(buf, 0, len);
+    _spi->transfer(buf, len);
+    return true;
+  }
+
+  /** Ends a long read. */
+  void endBurst(void) { frameEnd(); }
+
+private:
+  void frameBegin(void) {
+    _spi->beginTransaction(
+        SPISettings(L3GD20_SPI_FREQUENCY, MSBFIRST, SPI_MODE3));
+    digitalWrite(_cs, LOW);
+  }
+
+  void frameEnd(void) {
+    digitalWrite(_cs, HIGH);
+    _spi->endTransaction();
+  }
+
+  SPIClass *_spi;
+  int8_t _cs;
+  uint8_t _register;
+};
+
+/**
+ * Bit-banged SPI transport on any four GPIO pins. Uses direct port access
+ * where the core exposes it (AVR, SAMD) and digitalWrite() elsewhere.
+ */
+class Adafruit_L3GD20_SoftSPI {
+public:
+  /**
+   * @param cs   The chip select pin.
+   * @param sck  The clock pin.
+   * @param mosi The data pin towards the sensor (SDA/SDI).
+   * @param miso The data pin from the sensor (SDO).
+   */
+  Adafruit_L3GD20_SoftSPI(int8_t cs, int8_t sck, int8_t mosi, int8_t miso)
+      : _cs(cs), _sck(sck), _mosi(mosi), _miso(miso), _register(0) {}
+
+  /** Configures the pins; the clock idles high in SPI mode 3. */
+  void begin(void) {
+    pinMode(_cs, OUTPUT);
+    pinMode(_sck, OUTPUT);
+    pinMode(_mosi, OUTPUT);
+    pinMode(_miso, INPUT);
+    digitalWrite(_cs, HIGH);
+    digitalWrite(_sck, HIGH);
+#ifdef L3GD20_FAST_PINIO
+    _sckPort = portOutputRegister(digitalPinToPort(_sck));
+    _sckMask = digitalPinToBitMask(_sck);
+    _mosiPort = portOutputRegister(digitalPinToPort(_mosi));
+    _mosiMask = digitalPinToBitMask(_mosi);
+    _misoPort = portInputRegister(digitalPinToPort(_miso));
+    _misoMask = digitalPinToBitMask(_miso);
+#endif
+  }
+
+  /**
+   * Writes a single register.
+   * @param reg   The register to write to.
+   * @param value The value to assign to 'reg'.
+   */
+  void write8(uint8_t reg, uint8_t value) {
+    digitalWrite(_cs, LOW);
+    transfer(reg & 0x3F);
+    transfer(value);
+    digitalWrite(_cs, HIGH);
+  }
+
+  /**
+   * Writes consecutive registers in one auto-increment frame.
+   * @param reg The first register to write to.
+   * @param buf The values to write.
+   * @param len The number of registers to write.
+   * @return Always true, SPI has no acknowledge.
+   */
+  bool writeBytes(uint8_t reg, const uint8_t *buf, uint8_t len) {
+    digitalWrite(_cs, LOW);
+    transfer((reg & 0x3F) | 0x40); // WRITE, auto-increment
+    for (uint8_t i = 0; i < len; i++) {
+      transfer(buf[i]);
+    }
+    digitalWrite(_cs, HIGH);
+    return true;
+  }
+
+  /**
+   * Reads a single register.
+   * @param reg The register to read.
+   * @return The value read from 'reg'.
+   */
+  uint8_t read8(uint8_t reg) {
+    digitalWrite(_cs, LOW);
+    transfer((reg & 0x3F) | 0x80); // set READ bit
+    uint8_t value = transfer(0x00);
+    digitalWrite(_cs, HIGH);
+    return value;
+  }
+
+  /**
+   * Remembers the first register of a following receive().
+   * @param reg The first register to read.
+   * @return Always true.
+   */
+  bool select(uint8_t reg) {
+    _register = reg;
+    return true;
+  }
+
+  /**
+   * Reads bytes starting at the register set by select().
+   * @param buf The placeholder where the register values are written.
+   * @param len The number of bytes to read.
+   * @return Always true, SPI has no acknowledge.
+   */
+  bool receive(uint8_t *buf, uint8_t len) {
+    beginBurst(_register);
+    burst(buf, len);
+    endBurst();
+    return true;
+  }
+
+  /**
+   * Reads a block of consecutive registers.
+   * @param reg The first register to read.
+   * @param buf The placeholder where the register values are written.
+   * @param len The number of bytes to read.
+   * @return Always true, SPI has no acknowledge.
+   */
+  bool readBytes(uint8_t reg, uint8_t *buf, uint8_t len) {
+    select(reg);
+    return receive(buf, len);
+  }
+
+  /**
+   * Starts a long read as a single chip-select frame.
+   * @param reg The first register to read.
+   */
+  void beginBurst(uint8_t reg) {
+    digitalWrite(_cs, LOW);
+    transfer((reg & 0x3F) | 0xC0); // READ, auto-increment
+  }
+
+  /**
+   * Clocks out the next part of a long read.
+   * @param buf The placeholder where the register values are written.
+   * @param len The number of bytes to read.
+   * @return Always true, SPI has no acknowledge.
+   */
+  bool burst(uint8_t *buf, uint8_t len) {
+    for (uint8_t i = 0; i < len; i++) {
+      buf[i] = transfer(0x00);
+    }
+    return true;
+  }
+
+  /** Ends a long read. */
+  void endBurst(void) { digitalWrite(_cs, HIGH); }
+
+private:
+  /* Mode 3: shift out on the falling edge, sample on the rising edge */
+  uint8_t transfer(uint8_t x) {
+    uint8_t reply = 0;
+    for (uint8_t bit = 0x80; bit; bit >>= 1) {
+#ifdef L3GD20_FAST_PINIO
+      *_sckPort &= ~_sckMask;
+      if (x & bit) {
+        *_mosiPort |= _mosiMask;
+      } else {
+        *_mosiPort &= ~_mosiMask;
+      }
+      *_sckPort |= _sckMask;
+      if (*_misoPort & _misoMask) {
+        reply |= bit;
+      }
+#else
+      digitalWrite(_sck, LOW);
+      digitalWrite(_mosi, (x & bit) ? HIGH : LOW);
+      digitalWrite(_sck, HIGH);
+      if (digitalRead(_miso)) {
+        reply |= bit;
+      }
+#endif
+    }
+    return reply;
+  }
+
+  int8_t _cs, _sck, _mosi, _miso;
+  uint8_t _register;
+#ifdef L3GD20_FAST_PINIO
+  l3gd20PortReg_t *_sckPort, *_mosiPort, *_misoPort;
+  l3gd20PortMask_t _sckMask, _mosiMask, _misoMask;
+#endif
+};
+
+/**
+ * Decodes consecutive OUT_X_L..OUT_Z_H register blocks into raw samples.
+ *
+ * @param bytes The register values, six per sample, low byte first.
+ * @param out   The placeholder where the raw samples are written.
+ * @param count The number of samples to decode.
+ */
+inline void l3gd20Decode(const uint8_t *bytes, gyroRawData_t *out,
+                         uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    const uint8_t *b = &bytes[i * 6];
+    out[i].x = (int16_t)(b[0] | (b[1] << 8));
+    out[i].y = (int16_t)(b[2] | (b[3] << 8));
+    out[i].z = (int16_t)(b[4] | (b[5] << 8));
+  }
+}
+
+/**
+ * Reads a known number of samples from the FIFO over any transport, one
+ * receive buffer at a time. Over SPI the whole drain is a single frame.
+ *
+ * @param bus   The transport the sensor is connected to.
+ * @param buf   The placeholder where the raw samples are written.
+ * @param count The number of samples to read. Must not exceed the current
+ *              FIFO level.
+ *
+ * @return The number of samples written to 'buf'.
+ */
+template <class Bus>
+size_t l3gd20DrainFifo(Bus &bus, gyroRawData_t *buf, size_t count) {
+  const uint8_t samplesPerBurst = L3GD20_I2C_BUFFER_SIZE / 6;
+  uint8_t bytes[samplesPerBurst * 6];
+  size_t done = 0;
+
+  bus.beginBurst(GYRO_REGISTER_OUT_X_L);
+  while (done < count) {
+    uint8_t n = samplesPerBurst;
+    if (count - done < n) {
+      n = count - done;
+    }
+    if (!bus.burst(bytes, n * 6)) {
+      break;
+    }
+    l3gd20Decode(bytes, &buf[done], n);
+    done += n;
+  }
+  bus.endBurst();
+
+  return done;
+}
+
+/**
+ * Gets the CTRL_REG1 value for a data rate and bandwidth, normal mode with
+ * all three axes enabled. LOW_ODR rates use their DR bits with Low_ODR set.
+ *
+ * @param rate      The output data rate.
+ * @param bandwidth The low-pass cutoff selection.
+ *
+ * @return The register value, a compile-time constant for constant
+ *         arguments.
+ */
+constexpr uint8_t l3gd20Ctrl1(gyroDataRate_t rate, gyroBandwidth_t bandwidth) {
+  return ((rate & 0x03) << 6) | (bandwidth << 4) | 0x0F;
+}
+
+/**
+ * Gets the FS1..0 bits of CTRL_REG4 for a range.
+ *
+ * @param range The measurement range.
+ *
+ * @return The register value, a compile-time constant for a constant range.
+ */
+constexpr uint8_t l3gd20RangeBits(gyroRange_t range) {
+  return (range == GYRO_RANGE_2000DPS)  ? 0x20
+         : (range == GYRO_RANGE_500DPS) ? 0x10
+                                        : 0x00;
+}
+
+/**
+ * Gets the factor that converts raw samples at a range to rad/s.
+ *
+ * @param range The measurement range.
+ *
+ * @return The fused sensitivity and unit conversion.
+ */
+constexpr float l3gd20RangeScale(gyroRange_t range) {
+  return (range == GYRO_RANGE_2000DPS)  ? GYRO_SCALE_2000DPS
+         : (range == GYRO_RANGE_500DPS) ? GYRO_SCALE_500DPS
+                                        : GYRO_SCALE_250DPS;
+}
+
+/**
+ * Raw-data L3GD20 driver compiled for a single transport, e.g.
+ * Adafruit_L3GD20_Core<Adafruit_L3GD20_SPI>. Every bus access inlines to
+ * one path with no runtime dispatch. Use Adafruit_L3GD20_Unified for the
+ * Adafruit_Sensor interface.
+ */
+template <class Bus> class Adafruit_L3GD20_Core {
+public:
+  /**
+   * @param theBus The transport the sensor is connected to.
+   */
+  Adafruit_L3GD20_Core(const Bus &theBus)
+      : bus(theBus), _range(GYRO_RANGE_250DPS) {}
+
+  /**
+   * Checks the chip ID and enables all three axes.
+   * @param rng       The measurement range.
+   * @param rate      The output data rate.
+   * @param bandwidth The low-pass cutoff selection.
+   * @return True if an L3GD20 or L3GD20H answered, otherwise false.
+   */
+  bool begin(gyroRange_t rng = GYRO_RANGE_250DPS,
+             gyroDataRate_t rate = GYRO_DATARATE_95HZ,
+             gyroBandwidth_t bandwidth = GYRO_BANDWIDTH_0) {
+    bus.begin();
+    uint8_t id = bus.read8(GYRO_REGISTER_WHO_AM_I);
+    if ((id != L3GD20_ID) && (id != L3GD20H_ID)) {
+      return false;
+    }
+    _range = rng;
+    if ((id != L3GD20H_ID) && (rate > GYRO_DATARATE_760HZ)) {
+      rate = GYRO_DATARATE_95HZ; // no LOW_ODR on the L3GD20
+    }
+    bus.write8(GYRO_REGISTER_CTRL_REG1, 0x00);
+    bus.write8(GYRO_REGISTER_CTRL_REG1, l3gd20Ctrl1(rate, bandwidth));
+    if (id == L3GD20H_ID) {
+      bus.write8(GYRO_REGISTER_LOW_ODR, (rate >> 2) & 0x01);
+    }
+    bus.write8(GYRO_REGISTER_CTRL_REG4, l3gd20RangeBits(rng));
+    return true;
+  }
+
+  /**
+   * Reads the current output registers.
+   * @param sample The placeholder where the raw sample is written.
+   * @return True if the sample was read, otherwise false.
+   */
+  bool read(gyroRawData_t *sample) {
+    uint8_t b[6];
+    if (!bus.readBytes(GYRO_REGISTER_OUT_X_L, b, 6)) {
+      return false;
+    }
+    l3gd20Decode(b, sample, 1);
+    return true;
+  }
+
+  /**
+   * Enables the hardware FIFO.
+   * @param mode      The FIFO operating mode.
+   * @param watermark The FIFO watermark level, 0..31.
+   */
+  void enableFifo(gyroFifoMode_t mode = GYRO_FIFO_STREAM,
+                  uint8_t watermark = 0) {
+    /* Passing through bypass mode empties the FIFO and clears any overrun */
+    bus.write8(GYRO_REGISTER_FIFO_CTRL_REG, GYRO_FIFO_BYPASS);
+    uint8_t ctrl5 = bus.read8(GYRO_REGISTER_CTRL_REG5);
+    if (mode == GYRO_FIFO_BYPASS) {
+      bus.write8(GYRO_REGISTER_CTRL_REG5, ctrl5 & ~0x40);
+    } else {
+      bus.write8(GYRO_REGISTER_CTRL_REG5, ctrl5 | 0x40);
+      bus.write8(GYRO_REGISTER_FIFO_CTRL_REG, mode | (watermark & 0x1F));
+    }
+  }
+
+  /**
+   * Reads the number of unread samples in the FIFO.
+   * @return The FIFO level, 0..32.
+   */
+  uint8_t getFifoLevel(void) {
+    uint8_t src = bus.read8(GYRO_REGISTER_FIFO_SRC_REG);
+    if (src & 0x20) {
+      return 0;
+    }
+    return (src & 0x40) ? L3GD20_FIFO_SIZE : (src & 0x1F);
+  }
+
+  /**
+   * Reads up to 'max' samples from the FIFO.
+   * @param buf The placeholder where the raw samples are written.
+   * @param max The capacity of 'buf' in samples.
+   * @return The number of samples written to 'buf'.
+   */
+  size_t readFifo(gyroRawData_t *buf, size_t max) {
+    size_t count = getFifoLevel();
+    return l3gd20DrainFifo(bus, buf, (count < max) ? count : max);
+  }
+
+  /**
+   * Gets the factor that converts raw samples to rad/s.
+   * @return The fused sensitivity and unit conversion for the range.
+   */
+  float getScale(void) { return l3gd20RangeScale(_range); }
+
+  /** The transport, for direct register access. */
+  Bus bus;
+
+private:
+  gyroRange_t _range;
+};
+
+/**
+ * Adafruit_Sensor driver with the range, chip and data rate fixed at
+ * compile time, e.g.
+ * Adafruit_L3GD20_Fixed<Adafruit_L3GD20_I2C, GYRO_RANGE_500DPS>. The
+ * CTRL_REG values and the raw to rad/s factor are constants, and there is
+ * no auto-ranging, bias tracking or register shadow. Use
+ * Adafruit_L3GD20_Unified to change settings at run time.
+ */
+template <class Bus, gyroRange_t Range = GYRO_RANGE_250DPS,
+          gyroVariant_t Variant = GYRO_VARIANT_L3GD20,
+          gyroDataRate_t Rate = GYRO_DATARATE_95HZ,
+          gyroBandwidth_t Bandwidth = GYRO_BANDWIDTH_0>
+class Adafruit_L3GD20_Fixed : public Adafruit_Sensor,
+                              public Adafruit_L3GD20_Core<Bus> {
+  static_assert((Variant == GYRO_VARIANT_L3GD20H) ||
+                    (Rate <= GYRO_DATARATE_760HZ),
+                "the LOW_ODR rates need an L3GD20H");
+
+public:
+  /**
+   * @param theBus   The transport the sensor is connected to.
+   * @param sensorID The unique ID to differentiate the sensors from others.
+   */
+  Adafruit_L3GD20_Fixed(const Bus &theBus, int32_t sensorID = -1)
+      : Adafruit_L3GD20_Core<Bus>(theBus), _sensorID(sensorID) {}
+
+  /**
+   * Checks the chip ID and writes the compile-time configuration.
+   * @return True if the chip given as 'Variant' answered, otherwise false.
+   */
+  bool begin(void) {
+    this->bus.begin();
+    if (this->bus.read8(GYRO_REGISTER_WHO_AM_I) != Variant) {
+      return false;
+    }
+    this->bus.write8(GYRO_REGISTER_CTRL_REG1, 0x00);
+    this->bus.write8(GYRO_REGISTER_CTRL_REG1, l3gd20Ctrl1(Rate, Bandwidth));
+    if (Variant == GYRO_VARIANT_L3GD20H) {
+      this->bus.write8(GYRO_REGISTER_LOW_ODR, (Rate >> 2) & 0x01);
+    }
+    this->bus.write8(GYRO_REGISTER_CTRL_REG4, l3gd20RangeBits(Range));
+    return true;
+  }
+
+  /**
+   * Gets the factor that converts raw samples to rad/s.
+   * @return The fused sensitivity and unit conversion for 'Range'.
+   */
+  static constexpr float getScale(void) { return l3gd20RangeScale(Range); }
+
+  /**
+   * Gets the time between two samples.
+   * @return The nominal sample period in microseconds.
+   */
+  static constexpr uint32_t getSamplePeriod(void) {
+    return (Variant == GYRO_VARIANT_L3GD20H)
+               ? ((Rate > GYRO_DATARATE_800HZ) ? 80000UL >> (Rate - 4)
+                                               : 10000UL >> Rate)
+               : (Rate == GYRO_DATARATE_95HZ)    ? 10526UL
+               : (Rate == GYRO_DATARATE_190HZ) ? 5263UL
+               : (Rate == GYRO_DATARATE_380HZ) ? 2632UL
+                                               : 1316UL;
+  }
+
+  /**
+   * Reads the current output registers as rad/s. There is no sample
+   * clock, so unlike Adafruit_L3GD20_Unified the event is stamped with the
+   * millis() time the read started: the sample was taken at most one
+   * getSamplePeriod() before that.
+   * @param event The placeholder where the sample is written.
+   * @return True if the sample was read, otherwise false.
+   */
+  bool getEvent(sensors_event_t *event) {
+    gyroRawData_t sample;
+
+    memset(event, 0, sizeof(sensors_event_t));
+    event->version = sizeof(sensors_event_t);
+    event->sensor_id = _sensorID;
+    event->type = SENSOR_TYPE_GYROSCOPE;
+    event->timestamp = millis();
+    if (!this->read(&sample)) {
+      return false;
+    }
+    event->gyro.x = sample.x * getScale();
+    event->gyro.y = sample.y * getScale();
+    event->gyro.z = sample.z * getScale();
+    return true;
+  }
+
+  /**
+   * Gets the sensor_t data.
+   * @param sensor The placeholder where the description is written.
+   */
+  void getSensor(sensor_t *sensor) {
+    memset(sensor, 0, sizeof(sensor_t));
+    strncpy(sensor->name,
+            (Variant == GYRO_VARIANT_L3GD20H) ? "L3GD20H" : "L3GD20",
+            sizeof(sensor->name) - 1);
+    sensor->version = 1;
+    sensor->sensor_id = _sensorID;
+    sensor->type = SENSOR_TYPE_GYROSCOPE;
+    sensor->min_delay = getSamplePeriod();
+    sensor->max_value = Range * SENSORS_DPS_TO_RADS;
+    sensor->min_value = -(Range * SENSORS_DPS_TO_RADS);
+  }
+
+private:
+  int32_t _sensorID;
+};
+
 /**
  * Driver for the Adafruit L3GD20 3-Axis gyroscope.
  */
 class Adafruit_L3GD20_Unified : public Adafruit_Sensor {
 public:
   Adafruit_L3GD20_Unified(int32_t sensorID = -1);
+  Adafruit_L3GD20_Unified(int8_t cs, SPIClass *theSPI, int32_t sensorID = -1);
 
-  bool begin(gyroRange_t rng = GYRO_RANGE_250DPS, TwoWire *theWire = &Wire);
+  bool begin(gyroRange_t rng = GYRO_RANGE_250DPS, TwoWire *theWire = &Wire,
+             uint8_t addr = L3GD20_ADDRESS);
   void enableAutoRange(bool enabled);
+  void enableStatusRead(bool enabled);
+  void enableBiasCompensation(bool enabled, bool learn = true);
+  void getBiasTable(gyroBiasTable_t *table);
+  void setBiasTable(const gyroBiasTable_t *table);
+  void getBias(float *bias);
+  void getBiasFixed(gyroFixedData_t *bias);
+  void setAutoRangeHysteresis(uint8_t percent, uint16_t samples);
+  void setDataRate(gyroDataRate_t rate,
+                   gyroBandwidth_t bandwidth = GYRO_BANDWIDTH_0);
+  gyroDataRate_t getDataRate(void);
+  gyroBandwidth_t getBandwidth(void);
+  void setAxes(uint8_t axes);
+  uint8_t getAxes(void);
+  void setPowerMode(gyroPowerMode_t mode);
+  gyroPowerMode_t getPowerMode(void);
+  void setWakeLatency(uint32_t sleepUs, uint32_t powerDownUs);
+  uint32_t getWakeLatency(gyroPowerMode_t from);
+  bool isSettling(void);
+  void setHighPass(gyroHighPassMode_t mode, gyroHighPassCutoff_t cutoff);
+  void setFilterPath(gyroFilterPath_t path);
+  void setReference(uint8_t reference);
+  void resetHighPass(void);
+  uint32_t getSamplePeriod(void);
+  uint32_t getMeasuredPeriod(void);
+  gyroVariant_t getVariant(void);
   bool getEvent(sensors_event_t *);
+  bool getEventFixed(gyroFixedData_t *data);
   void getSensor(sensor_t *);
 
+  bool startRead(void);
+  gyroReadStatus_t pollRead(void);
+  bool completeRead(sensors_event_t *event);
+  void setReadLimits(uint8_t retries, uint16_t timeoutMs);
+
+  void enableFifo(gyroFifoMode_t mode = GYRO_FIFO_STREAM,
+                  uint8_t watermark = 0);
+  uint8_t getFifoLevel(void);
+  size_t readFifo(gyroRawData_t *buf, size_t max,
+                  uint32_t *timestamps = NULL);
+
+  void enableInterrupts(bool dataReady, bool watermark = false);
+  void markInterrupt(void);
+  void enableMotionInterrupt(uint8_t events,
+                             const gyroFixedData_t *thresholds,
+                             uint8_t duration = 0, bool all = false);
+  void disableMotionInterrupt(void);
+  uint8_t handleMotionInterrupt(void);
+  bool attachSampleBuffer(gyroRawData_t *storage, uint8_t size,
+                          uint32_t *timestamps = NULL);
+  size_t handleInterrupt(void);
+  size_t available(void);
+  size_t readSamples(gyroRawData_t *buf, size_t max,
+                     uint32_t *timestamps = NULL);
+
+  bool startDutyCycle(uint32_t intervalMs, uint8_t batch,
+                      gyroPowerMode_t idle = GYRO_POWER_SLEEP);
+  size_t pollDutyCycle(gyroRawData_t *buf, size_t max,
+                       uint32_t *timestamps = NULL);
+  uint32_t getDutyCycleDelay(void);
+  gyroDutyState_t getDutyCycleState(void);
+  void stopDutyCycle(void);
+
+  gyroRange_t getRange(void);
+  float getScale(void);
+  void convertSamples(const gyroRawData_t *in, float *out, size_t count);
+  void convertSamples(const gyroRawData_t *in, float *x, float *y, float *z,
+                      size_t count);
+  void convertSamplesFixed(const gyroRawData_t *in, gyroFixedData_t *out,
+                           size_t count);
+
+  void setBusCapture(l3gd20CaptureFunc_t func, void *context = NULL);
+#ifdef L3GD20_BUS_REPLAY
+  void setBusReplay(l3gd20ReplayFunc_t func, void *context = NULL);
+#endif
+
+  /** Number of data-ready samples dropped because the sample buffer was
+      full. */
+  uint32_t droppedSamples;
+
   /** Raw sensor data from the last successful read event. */
   gyroRawData_t raw;
 
+  /** micros() time at which the sensor took the sample in 'raw'. */
+  uint32_t timestamp;
+
+  /** Raw OUT_TEMP from the last status read. Drops by 1 per degree C, the
+      offset is not calibrated. */
+  int8_t temperature;
+
+  /** Number of status reads that found a sample overwritten unread
+      (ZYXOR). */
+  uint32_t overruns;
+
 private:
-  void write8(byte reg, byte value);
+  friend class Adafruit_L3GD20_Group;
+
+  void init(int32_t sensorID);
+  bool writeBytes(byte reg, const uint8_t *buf, uint8_t len);
   byte read8(byte reg);
+  uint8_t readConfig(byte reg);
+  void writeConfig(byte reg, uint8_t value);
+  void updateConfig(byte reg, uint8_t mask, uint8_t value);
+  bool flushConfig(void);
+  bool selectRegister(byte reg);
+  bool receiveBytes(uint8_t *buf, uint8_t len);
+  bool readBytes(byte reg, uint8_t *buf, uint8_t len);
+  size_t drainBus(gyroRawData_t *buf, size_t count);
+  void capture(gyroBusOp_t op, uint8_t reg, const void *data,
+               uint8_t length, bool ok, uint32_t start);
+  bool readSample(void);
+  uint8_t outputWindow(uint8_t skip, uint8_t *length);
+  void decodeOutput(const uint8_t *b, uint8_t from, gyroRawData_t *sample);
+  void maskAxes(gyroRawData_t *buf, size_t count);
+  gyroReadStatus_t readOutput(gyroRawData_t *sample);
+  bool parseStatus(const uint8_t *b);
+  size_t staleOutput(uint8_t status);
+  size_t staleFifo(size_t count);
+  bool isSaturated(const gyroRawData_t &sample);
+  void autoRange(gyroRawData_t *buf, size_t count, size_t stale);
+  bool rangeDrained(void);
+  void changeRange(gyroRange_t rng);
+  void writeMotionThresholds(void);
+  void scaleEvent(sensors_event_t *event);
+  void trackBias(const gyroRawData_t *buf, size_t count);
+  void storeBias(void);
+  bool currentBias(int32_t *bias);
+  size_t drainFifo(gyroRawData_t *buf, size_t count, uint32_t *timestamps);
+  uint8_t syncFifo(void);
+  void syncOutput(uint32_t now);
+  uint32_t sampleTime(uint8_t n);
+  void advanceClock(int32_t n);
+  void seekClock(uint32_t t);
+  void lockClock(uint32_t t, uint8_t n);
+  void correctClock(int32_t error, uint8_t n, uint8_t phaseShift,
+                    uint8_t periodShift);
+  void restartClock(void);
+  bool settled(uint32_t t);
+  uint32_t nominalPeriod(void);
+  Adafruit_L3GD20_I2C _i2cBus;
+  Adafruit_L3GD20_SPI _spiBus;
+  bool _useSpi;
   gyroRange_t _range;
   int32_t _sensorID;
   bool _autoRangeEnabled;
+  bool _statusRead;
+  bool _initialized;
+  gyroVariant_t _variant;
+  gyroDataRate_t _dataRate;
+  gyroBandwidth_t _bandwidth;
+  uint8_t _axes;
+  gyroHighPassMode_t _highPassMode;
+  gyroHighPassCutoff_t _highPassCutoff;
+  gyroFilterPath_t _filterPath;
+  uint8_t _reference;
+  gyroFifoMode_t _fifoMode;
+  /* INT1 thresholds in mdps, rewritten in LSB whenever the range changes */
+  gyroFixedData_t _motionThreshold;
+  bool _motionEnabled;
+
+  /* Power modes. Samples taken before _settleUntil, after a wake, are
+     discarded while _settling is set. _wakeFrom is the deepest mode
+     entered since the last wake. */
+  gyroPowerMode_t _powerMode;
+  gyroPowerMode_t _wakeFrom;
+  uint32_t _sleepWakeUs;
+  uint32_t _powerDownWakeUs;
+  uint32_t _settleUntil;
+  bool _settling;
+
+  /* Duty-cycled acquisition. _dutyStart is the micros() time the current
+     batch started, _dutyNext that of the next step of the state machine. */
+  gyroDutyState_t _dutyState;
+  gyroPowerMode_t _dutyIdle;
+  uint32_t _dutyInterval;
+  uint32_t _dutyStart;
+  uint32_t _dutyNext;
+  uint8_t _dutyBatch;
+
+  /* Auto-ranging. Samples taken before the last range change can still be
+     in the output registers or the FIFO; they are rescaled when read, and
+     the range is not changed again until they are all gone. */
+  gyroRange_t _rangeFloor;
+  gyroRange_t _staleRange;
+  uint8_t _staleSamples;
+  bool _rangeSettling;
+  uint8_t _rangeDownPercent;
+  uint16_t _rangeDownSamples;
+  uint16_t _rangeCalm;
+
+  /* Bias compensation. Welford running mean and sum of squared deviations
+     of the current still period, in LSB at 250 dps. */
+  bool _biasEnabled;
+  bool _biasLearning;
+  gyroBiasTable_t _biasTable;
+  float _stillMean[3];
+  float _stillM2[3];
+  uint16_t _stillCount;
+  uint32_t _temperatureTime;
+
+  /* Shadow of the writable registers CTRL_REG1..LOW_ODR (0x20..0x39).
+     Bit n of the masks stands for register 0x20 + n. */
+  uint8_t _shadow[L3GD20_SHADOW_SIZE];
+  uint32_t _shadowValid;
+  uint32_t _shadowDirty;
+
+  /* Sample clock. Sample 0 is the next sample in the FIFO, or with the
+     FIFO off the newest one in the output registers. It was taken at
+     _clockBase + _clockFrac / 256 us, sample n at n * _clockPeriod / 256 us
+     after it. _clockSpan counts the samples since the last correction. */
+  uint32_t _clockBase;
+  uint8_t _clockFrac;
+  uint32_t _clockPeriod;
+  int32_t _clockSpan;
+  uint32_t _clockSync;
+  /* Set by markInterrupt() */
+  uint32_t _irqTime;
+  bool _irqPending;
+
+  /* Single-producer/single-consumer sample ring. handleInterrupt() only
+     advances _ringHead, readSamples() only advances _ringTail. */
+  gyroRawData_t *_ring;
+  uint32_t *_ringTimes;
+  uint8_t _ringMask;
+  uint8_t _ringHead;
+  uint8_t _ringTail;
+  /* Samples before _ringMark were stored at _ringStaleRange. Set by
+     handleInterrupt(), cleared by readSamples() once it passes the mark. */
+  bool _ringStale;
+  uint8_t _ringMark;
+  /* Samples handleInterrupt() stored but has not published yet */
+  uint8_t _ringPending;
+  gyroRange_t _ringStaleRange;
+  gyroRange_t _ringRange;
+
+  /* Non-blocking reader */
+  gyroReadStatus_t _readStatus;
+  uint8_t _readStep;
+  uint8_t _readSkip;
+  uint8_t _readFrom;
+  uint8_t _readLength;
+  uint8_t _readAttempts;
+  uint8_t _readRetries;
+  uint16_t _readTimeout;
+  uint32_t _readStart;
+  uint32_t _readTimestamp;
+
+  /* Bus capture and replay. _selected is the register of the last
+     address phase, _captureEnd the micros() time the last captured
+     transaction ended. */
+  uint8_t _selected;
+  l3gd20CaptureFunc_t _captureFunc;
+  void *_captureContext;
+  uint32_t _captureEnd;
+#ifdef L3GD20_BUS_REPLAY
+  l3gd20ReplayFunc_t _replayFunc;
+  void *_replayContext;
+#endif
+};
+
+/**
+ * Reads several L3GD20 sensors in one pass, e.g. on different buses or at
+ * both I2C addresses.
+ */
+class Adafruit_L3GD20_Group {
+public:
+  Adafruit_L3GD20_Group(Adafruit_L3GD20_Unified **gyros, uint8_t count);
+
+  uint8_t read(gyroRawData_t *samples, uint32_t *timestamp = NULL);
+
+private:
+  Adafruit_L3GD20_Unified **_gyros;
+  uint8_t _count;
+  uint8_t _first;
+};
+
+/**
+ * Integrates batches of raw samples into an orientation quaternion, in
+ * floating point.
+ */
+class Adafruit_L3GD20_Attitude {
+public:
+  Adafruit_L3GD20_Attitude(void);
+
+  void reset(void);
+  void update(const gyroRawData_t *samples, const uint32_t *timestamps,
+              size_t count, float scale, const float *bias = NULL);
+  void getQuaternion(float *q);
+
+private:
+  float _q[4];
+  uint32_t _last;
+  bool _started;
+};
+
+/**
+ * Integrates batches of raw samples into an orientation quaternion, in
+ * integer arithmetic only.
+ */
+class Adafruit_L3GD20_AttitudeFixed {
+public:
+  Adafruit_L3GD20_AttitudeFixed(void);
+
+  void reset(void);
+  void update(const gyroRawData_t *samples, const uint32_t *timestamps,
+              size_t count, gyroRange_t range,
+              const gyroFixedData_t *bias = NULL);
+  void getQuaternion(int32_t *q);
+
+private:
+  int32_t _q[4];
+  uint32_t _last;
+  bool _started;
+};
+
+/*=========================================================================
+    BINARY STREAM
+    -----------------------------------------------------------------------
+    Frames of up to L3GD20_STREAM_MAX_SAMPLES raw samples, little-endian:
+
+      0xA5               sync
+      flags              version << 4 | range (0 = 250, 1 = 500, 2 = 2000)
+      count              samples in the frame, 1..32
+      length (2)         payload bytes
+      t0 (4)             micros() time of the first sample
+      payload            varint time span from the first to the last
+                         sample, then per sample and axis the zigzag
+                         varint difference to the previous sample (to 0
+                         for the first)
+      crc (2)            CRC-16/CCITT-FALSE of flags..payload
+
+    The decoder spaces the samples evenly over the span. Every frame
+    stands alone, so a lost or corrupted one costs only its own samples.
+    -----------------------------------------------------------------------*/
+size_t l3gd20EncodeFrame(uint8_t *out, size_t size,
+                         const gyroRawData_t *samples,
+                         const uint32_t *timestamps, size_t count,
+                         gyroRange_t range);
+
+/**
+ * Reassembles binary stream frames from a byte stream, e.g. a UART log,
+ * and checks their CRC.
+ */
+class Adafruit_L3GD20_StreamDecoder {
+public:
+  Adafruit_L3GD20_StreamDecoder(void);
+
+  void reset(void);
+  bool feed(uint8_t byte);
+  void convertSamples(float *out);
+
+  /** Samples of the last complete frame. */
+  gyroRawData_t samples[L3GD20_STREAM_MAX_SAMPLES];
+  /** micros() time of each sample of the last complete frame. */
+  uint32_t timestamps[L3GD20_STREAM_MAX_SAMPLES];
+  /** Number of samples in the last complete frame. */
+  uint8_t count;
+  /** Range the samples of the last complete frame were taken at. */
+  gyroRange_t range;
+  /** Bad frames and false sync bytes skipped, e.g. after line noise. */
+  uint32_t errors;
+
+private:
+  bool check(void);
+  bool parse(void);
+  void resync(void);
+
+  uint8_t _buf[L3GD20_STREAM_MAX_FRAME];
+  uint16_t _len;
 };
 
 /* Non Unified (old) driver for compatibility reasons */
@@ -137,6 +1608,7 @@ private:
   byte read8(l3gd20Registers_t reg);
   uint8_t SPIxfer(uint8_t x);
 
+  TwoWire *_i2c;
   byte address;
   l3gd20Range_t range;
   int8_t _miso, _mosi, _clk, _cs;
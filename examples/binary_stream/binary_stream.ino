@@ -0,0 +1,44 @@
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include <Adafruit_L3GD20_U.h>
+
+/* Logs every sample at 760 Hz as compact binary frames. Capture the
+   serial port to a file and decode it on the PC with the l3gd20_decode
+   tool in extras/host_sim. */
+
+/* Assign a unique ID to this sensor at the same time */
+Adafruit_L3GD20_Unified gyro = Adafruit_L3GD20_Unified(20);
+
+gyroRawData_t samples[L3GD20_FIFO_SIZE];
+uint32_t sampleTimes[L3GD20_FIFO_SIZE];
+uint8_t frame[L3GD20_STREAM_MAX_FRAME];
+
+void setup(void)
+{
+  /* About 5 bytes per sample in motion, 4 kB/s at 760 Hz */
+  Serial.begin(115200);
+
+  /* Initialise the sensor */
+  if(!gyro.begin())
+  {
+    /* There was a problem detecting the L3GD20 ... check your connections */
+    while(1);
+  }
+
+  gyro.enableAutoRange(true);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+}
+
+void loop(void)
+{
+  /* One frame per FIFO batch */
+  size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE, sampleTimes);
+  if (count == 0)
+  {
+    return;
+  }
+  size_t length = l3gd20EncodeFrame(frame, sizeof(frame), samples,
+                                    sampleTimes, count, gyro.getRange());
+  Serial.write(frame, length);
+}
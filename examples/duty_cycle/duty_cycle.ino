@@ -0,0 +1,55 @@
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include <Adafruit_L3GD20_U.h>
+
+/* Assign a unique ID to this sensor at the same time */
+Adafruit_L3GD20_Unified gyro = Adafruit_L3GD20_Unified(20);
+
+gyroRawData_t samples[L3GD20_FIFO_SIZE];
+uint32_t times[L3GD20_FIFO_SIZE];
+float rates[3 * L3GD20_FIFO_SIZE];
+
+void setup(void)
+{
+  Serial.begin(115200);
+  Serial.println("Gyroscope Duty Cycle Test"); Serial.println("");
+
+  /* Initialise the sensor */
+  if(!gyro.begin())
+  {
+    /* There was a problem detecting the L3GD20 ... check your connections */
+    Serial.println("Ooops, no L3GD20 detected ... Check your wiring!");
+    while(1);
+  }
+
+  /* 32 samples at 760 Hz every 5 s, powered down in between. The gyro
+     is on for the wake latency plus 42 ms out of every 5 s. */
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.startDutyCycle(5000, 32, GYRO_POWER_DOWN);
+}
+
+void loop(void)
+{
+  size_t count = gyro.pollDutyCycle(samples, L3GD20_FIFO_SIZE, times);
+
+  if (count == 0)
+  {
+    /* Sleep the MCU for up to this long; nothing touches the bus before */
+    uint32_t idle = gyro.getDutyCycleDelay();
+    delay(idle / 1000);
+    return;
+  }
+
+  /* Print the mean rate of the batch in rad/s */
+  float mean[3] = { 0, 0, 0 };
+  gyro.convertSamples(samples, rates, count);
+  for (size_t i = 0; i < count; i++)
+  {
+    for (uint8_t a = 0; a < 3; a++) mean[a] += rates[3 * i + a] / count;
+  }
+  Serial.print(times[0]); Serial.print(" us  ");
+  Serial.print("X: "); Serial.print(mean[0]); Serial.print("  ");
+  Serial.print("Y: "); Serial.print(mean[1]); Serial.print("  ");
+  Serial.print("Z: "); Serial.print(mean[2]); Serial.print("  ");
+  Serial.println("rad/s ");
+}
@@ -0,0 +1,65 @@
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include <Adafruit_L3GD20_U.h>
+
+/* Connect the DRDY/INT2 pin of the breakout to this pin */
+#define GYRO_INT_PIN 2
+
+/* Assign a unique ID to this sensor at the same time */
+Adafruit_L3GD20_Unified gyro = Adafruit_L3GD20_Unified(20);
+
+/* Storage for the samples moved out of the FIFO (must be a power of two) */
+gyroRawData_t sampleBuffer[64];
+uint32_t sampleTimes[64];
+volatile bool gyroReady = false;
+
+void gyroISR(void)
+{
+  /* Note when the samples were taken, then leave the reading to loop();
+     Wire can't be used from an interrupt on every core */
+  gyro.markInterrupt();
+  gyroReady = true;
+}
+
+void setup(void)
+{
+  Serial.begin(115200);
+  Serial.println("Gyroscope FIFO Test"); Serial.println("");
+
+  /* Initialise the sensor */
+  if(!gyro.begin())
+  {
+    /* There was a problem detecting the L3GD20 ... check your connections */
+    Serial.println("Ooops, no L3GD20 detected ... Check your wiring!");
+    while(1);
+  }
+
+  /* Collect samples in the FIFO and raise DRDY/INT2 once 16 are waiting */
+  gyro.attachSampleBuffer(sampleBuffer, 64, sampleTimes);
+  gyro.enableFifo(GYRO_FIFO_STREAM, 16);
+  gyro.enableInterrupts(false, true);
+
+  pinMode(GYRO_INT_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(GYRO_INT_PIN), gyroISR, RISING);
+}
+
+void loop(void)
+{
+  if (gyroReady)
+  {
+    gyroReady = false;
+    gyro.handleInterrupt();
+  }
+
+  /* Consume everything collected so far in one batch */
+  gyroRawData_t batch[16];
+  uint32_t times[16];
+  size_t count = gyro.readSamples(batch, 16, times);
+  for (size_t i = 0; i < count; i++)
+  {
+    Serial.print(times[i]); Serial.print(" us: ");
+    Serial.print(batch[i].x); Serial.print(" ");
+    Serial.print(batch[i].y); Serial.print(" ");
+    Serial.println(batch[i].z);
+  }
+}
@@ -0,0 +1,57 @@
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include <Adafruit_L3GD20_U.h>
+
+/* Connect the INT1 pin of the breakout to this pin */
+#define GYRO_INT1_PIN 3
+
+/* Assign a unique ID to this sensor at the same time */
+Adafruit_L3GD20_Unified gyro = Adafruit_L3GD20_Unified(20);
+
+volatile bool gyroMoved = false;
+
+void motionISR(void)
+{
+  /* Leave the bus to loop(); Wire can't be used from an interrupt on
+     every core */
+  gyroMoved = true;
+}
+
+void setup(void)
+{
+  Serial.begin(115200);
+  Serial.println("Gyroscope Wake On Motion Test"); Serial.println("");
+
+  /* Initialise the sensor */
+  if(!gyro.begin())
+  {
+    /* There was a problem detecting the L3GD20 ... check your connections */
+    Serial.println("Ooops, no L3GD20 detected ... Check your wiring!");
+    while(1);
+  }
+
+  /* Raise INT1 once any axis turns faster than 20 dps for 10 samples */
+  gyroFixedData_t thresholds = { 20000, 20000, 20000 };
+  gyro.enableMotionInterrupt(GYRO_MOTION_ANY_HIGH, &thresholds, 10);
+
+  pinMode(GYRO_INT1_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(GYRO_INT1_PIN), motionISR, RISING);
+}
+
+void loop(void)
+{
+  if (!gyroMoved)
+  {
+    /* Put the MCU to sleep here; nothing touches the bus until INT1 */
+    return;
+  }
+  gyroMoved = false;
+
+  /* Reading the source releases INT1 for the next wake-up */
+  uint8_t events = gyro.handleMotionInterrupt();
+  Serial.print("Motion on");
+  if (events & GYRO_MOTION_X_HIGH) Serial.print(" X");
+  if (events & GYRO_MOTION_Y_HIGH) Serial.print(" Y");
+  if (events & GYRO_MOTION_Z_HIGH) Serial.print(" Z");
+  Serial.println("");
+}
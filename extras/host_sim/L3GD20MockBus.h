@@ -0,0 +1,93 @@
+/*!
+ * @file L3GD20MockBus.h
+ *
+ * Transport for Adafruit_L3GD20_Core that talks to an L3GD20Model directly,
+ * without a bus in between. Takes no simulated time and records every
+ * register access, so driver logic can be tested on its own.
+ */
+
+#ifndef __L3GD20_MOCK_BUS_H__
+#define __L3GD20_MOCK_BUS_H__
+
+#include "L3GD20Model.h"
+
+/*!
+ * @brief Direct register access to a simulated sensor
+ */
+class L3GD20MockBus {
+public:
+  /** @param device The simulated sensor every access goes to */
+  L3GD20MockBus(L3GD20Model *device)
+      : reads(0), writes(0), _device(device), _register(0) {}
+
+  /** Nothing to enable */
+  void begin(void) {}
+
+  /** Writes 'value' to 'reg' */
+  void write8(uint8_t reg, uint8_t value) {
+    writes++;
+    _device->select(reg, false);
+    _device->write(value);
+  }
+
+  /** Writes 'len' registers starting at 'reg' */
+  bool writeBytes(uint8_t reg, const uint8_t *buf, uint8_t len) {
+    writes++;
+    _device->select(reg, true);
+    for (uint8_t i = 0; i < len; i++) {
+      _device->write(buf[i]);
+    }
+    return true;
+  }
+
+  /** Reads 'reg' */
+  uint8_t read8(uint8_t reg) {
+    reads++;
+    _device->select(reg, false);
+    return _device->read();
+  }
+
+  /** Remembers the first register of a following receive() */
+  bool select(uint8_t reg) {
+    _register = reg;
+    return true;
+  }
+
+  /** Reads 'len' registers from the one passed to select() */
+  bool receive(uint8_t *buf, uint8_t len) {
+    beginBurst(_register);
+    return burst(buf, len);
+  }
+
+  /** Reads 'len' registers starting at 'reg' */
+  bool readBytes(uint8_t reg, uint8_t *buf, uint8_t len) {
+    select(reg);
+    return receive(buf, len);
+  }
+
+  /** Starts an auto-increment read at 'reg' */
+  void beginBurst(uint8_t reg) {
+    reads++;
+    _device->select(reg, true);
+  }
+
+  /** Continues the current auto-increment read */
+  bool burst(uint8_t *buf, uint8_t len) {
+    for (uint8_t i = 0; i < len; i++) {
+      buf[i] = _device->read();
+    }
+    return true;
+  }
+
+  /** Ends the current auto-increment read */
+  void endBurst(void) {}
+
+  uint32_t reads;  ///< Register reads and bursts started
+  uint32_t writes; ///< Register writes and burst writes
+
+private:
+  L3GD20Model *_device;
+  uint8_t _register;
+};
+
+#endif
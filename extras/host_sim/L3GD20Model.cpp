@@ -0,0 +1,554 @@
+/*!
+ * @file L3GD20Model.cpp
+ *
+ * Register-file model of the L3GD20 and L3GD20H gyroscopes.
+ */
+
+#include "L3GD20Model.h"
+
+/* Sensitivity in millidegrees/s per LSB for each FS1..0 setting */
+static const float sensitivityMdps[4] = {8.75F, 17.5F, 70.0F, 70.0F};
+
+/* Sample periods in nanoseconds for each DR1..0 setting */
+static const uint32_t l3gd20PeriodNs[4] = {10526316, 5263158, 2631579,
+                                           1315789};
+static const uint32_t l3gd20hPeriodNs[4] = {10000000, 5000000, 2500000,
+                                            1250000};
+static const uint32_t l3gd20hLowPeriodNs[4] = {80000000, 40000000, 20000000,
+                                               20000000};
+
+/* High-pass cutoffs in Hz for each HPCF3..0 setting at each DR1..0 */
+static const float highPassHz[10][4] = {
+    {7.2F, 13.5F, 27.0F, 51.4F},    {3.5F, 7.2F, 13.5F, 27.0F},
+    {1.8F, 3.5F, 7.2F, 13.5F},      {0.9F, 1.8F, 3.5F, 7.2F},
+    {0.45F, 0.9F, 1.8F, 3.5F},      {0.18F, 0.45F, 0.9F, 1.8F},
+    {0.09F, 0.18F, 0.45F, 0.9F},    {0.045F, 0.09F, 0.18F, 0.45F},
+    {0.018F, 0.045F, 0.09F, 0.18F}, {0.009F, 0.018F, 0.045F, 0.09F}};
+
+/**************************************************************************/
+/*!
+    @brief  Instantiates a powered-up sensor with no rotation applied
+    @param  variant The chip to emulate
+*/
+/**************************************************************************/
+L3GD20Model::L3GD20Model(simVariant_t variant) {
+  _variant = variant;
+  _constant.x = 0;
+  _constant.y = 0;
+  _constant.z = 0;
+  _constant.temperature = 25;
+  _func = NULL;
+  _context = NULL;
+  _ppm = 0;
+  _sleepTurnOnNs = 0;
+  _powerDownTurnOnNs = 0;
+  reset();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Puts the register file back into its power-on state
+*/
+/**************************************************************************/
+void L3GD20Model::reset(void) {
+  memset(_regs, 0, sizeof(_regs));
+  _regs[0x0F] = (_variant == SIM_L3GD20H) ? 0xD7 : 0xD4;
+  _regs[0x20] = 0x07;
+  _pointer = 0;
+  _autoIncrement = false;
+  _nextSample = 0;
+  _wasActive = false;
+  _wasPoweredDown = true;
+  _validFrom = 0;
+  _modeSince = SimClock::now();
+  memset(modeNs, 0, sizeof(modeNs));
+  memset(_sampleTimes, 0, sizeof(_sampleTimes));
+  memset(_out, 0, sizeof(_out));
+  _hpActive = false;
+  _hpReset = false;
+  _int1Count = 0;
+  _fifoHead = 0;
+  _fifoCount = 0;
+  samplesGenerated = 0;
+  samplesLost = 0;
+  samplesTurnOn = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Injects a constant angular rate and temperature
+    @param  x           X axis rate in degrees/s
+    @param  y           Y axis rate in degrees/s
+    @param  z           Z axis rate in degrees/s
+    @param  temperature Raw OUT_TEMP value
+*/
+/**************************************************************************/
+void L3GD20Model::setSignal(float x, float y, float z, int8_t temperature) {
+  update();
+  _constant.x = x;
+  _constant.y = y;
+  _constant.z = z;
+  _constant.temperature = temperature;
+  _func = NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Injects a time-varying signal
+    @param  func    Called once per generated sample
+    @param  context Passed through to 'func'
+*/
+/**************************************************************************/
+void L3GD20Model::setSignal(simSignalFunc_t func, void *context) {
+  update();
+  _func = func;
+  _context = context;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Makes the sensor clock run fast or slow against the host clock
+    @param  ppm Positive values stretch the sample period
+*/
+/**************************************************************************/
+void L3GD20Model::setRateError(int32_t ppm) { _ppm = ppm; }
+
+/**************************************************************************/
+/*!
+    @brief  Makes the first samples after entering normal mode invalid
+    @param  sleepNs     Turn-on time when coming from sleep mode
+    @param  powerDownNs Turn-on time when coming from power-down mode
+*/
+/**************************************************************************/
+void L3GD20Model::setTurnOnTime(uint32_t sleepNs, uint32_t powerDownNs) {
+  _sleepTurnOnNs = sleepNs;
+  _powerDownTurnOnNs = powerDownNs;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the current sample period of the simulated sensor
+    @return The period in nanoseconds
+*/
+/**************************************************************************/
+uint32_t L3GD20Model::samplePeriodNs(void) {
+  uint8_t dr = _regs[0x20] >> 6;
+  if (_variant == SIM_L3GD20) {
+    return l3gd20PeriodNs[dr];
+  }
+  return (_regs[0x39] & 0x01) ? l3gd20hLowPeriodNs[dr] : l3gd20hPeriodNs[dr];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the time a recent sample was taken
+    @param  index   The sample, counted from reset(); one of the last 64
+    @return The simulated time in nanoseconds
+*/
+/**************************************************************************/
+uint64_t L3GD20Model::sampleTimeNs(uint32_t index) {
+  return _sampleTimes[index & 63];
+}
+
+/* Normal mode: PD set and at least one axis enabled */
+bool L3GD20Model::active(void) {
+  return (_regs[0x20] & 0x08) && (_regs[0x20] & 0x07);
+}
+
+/* Power mode selected by PD and the axis enables */
+simPowerMode_t L3GD20Model::powerMode(void) {
+  if (!(_regs[0x20] & 0x08)) {
+    return SIM_POWER_DOWN;
+  }
+  return (_regs[0x20] & 0x07) ? SIM_POWER_NORMAL : SIM_POWER_SLEEP;
+}
+
+/* FIFO enabled in CTRL_REG5 and a collecting mode selected */
+bool L3GD20Model::fifoActive(void) {
+  if (!(_regs[0x24] & 0x40)) {
+    return false;
+  }
+  switch (_regs[0x2E] >> 5) {
+  case 1: // FIFO
+  case 2: // Stream
+  case 3: // Stream-to-FIFO
+  case 6: // Dynamic stream (L3GD20H)
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Generates every sample that is due at the current simulated time
+*/
+/**************************************************************************/
+void L3GD20Model::update(void) {
+  uint64_t now = SimClock::now();
+
+  modeNs[powerMode()] += now - _modeSince;
+  _modeSince = now;
+
+  if (!active()) {
+    _wasActive = false;
+    _wasPoweredDown = !(_regs[0x20] & 0x08);
+    return;
+  }
+  if (!_wasActive) {
+    /* The drive and the filters need a while to settle */
+    _wasActive = true;
+    _nextSample = now + samplePeriodNs();
+    _validFrom = now + (_wasPoweredDown ? _powerDownTurnOnNs : _sleepTurnOnNs);
+  }
+  while (_nextSample <= now) {
+    produce(_nextSample);
+    uint64_t period = samplePeriodNs();
+    _nextSample += period + (int64_t)period * _ppm / 1000000;
+  }
+}
+
+/* First order high-pass in normal mode when HPen and OUT_SEL route the
+   output through it. Reference mode is not modelled and passes the input
+   unchanged. */
+void L3GD20Model::highPass(float *dps) {
+  if (!(_regs[0x24] & 0x10) || !(_regs[0x24] & 0x03)) {
+    _hpActive = false;
+    return;
+  }
+  if (!_hpActive) {
+    /* Switched in with empty state, the output steps to the input */
+    _hpActive = true;
+    _hpReset = false;
+    memset(_hpIn, 0, sizeof(_hpIn));
+    memset(_hpOut, 0, sizeof(_hpOut));
+  }
+  if (_hpReset) {
+    /* A reset settles the filter on the current input */
+    _hpReset = false;
+    memcpy(_hpIn, dps, sizeof(_hpIn));
+    memset(_hpOut, 0, sizeof(_hpOut));
+  }
+  uint8_t hpcf = _regs[0x21] & 0x0F;
+  float fc = highPassHz[(hpcf > 9) ? 9 : hpcf][_regs[0x20] >> 6];
+  float a = 1.0F / (1.0F + 2.0F * (float)M_PI * fc * samplePeriodNs() * 1e-9F);
+  bool reference = (_regs[0x21] & 0x30) == 0x10;
+
+  for (uint8_t i = 0; i < 3; i++) {
+    float x = dps[i];
+    if (!reference) {
+      _hpOut[i] = a * (_hpOut[i] + x - _hpIn[i]);
+      dps[i] = _hpOut[i];
+    }
+    _hpIn[i] = x;
+  }
+}
+
+/* INT1 generator: per-axis magnitude against TSH_x, combined with AND/OR
+   and debounced by INT1_DURATION samples. WAIT is not modelled. */
+void L3GD20Model::thresholdEvents(void) {
+  uint8_t cfg = _regs[0x30];
+  uint8_t enabled = cfg & 0x3F;
+  uint8_t events = 0;
+
+  if (!enabled) {
+    _int1Count = 0;
+    return;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    int32_t threshold = ((_regs[0x32 + 2 * i] & 0x7F) << 8) |
+                        _regs[0x33 + 2 * i];
+    int32_t magnitude = abs((int32_t)_out[i]);
+    if (magnitude > threshold) {
+      events |= 0x02 << (2 * i);
+    } else if (magnitude < threshold) {
+      events |= 0x01 << (2 * i);
+    }
+  }
+  events &= enabled;
+
+  bool hit = (cfg & 0x80) ? (events == enabled) : (events != 0);
+  if (!hit) {
+    _int1Count = 0;
+  } else if (_int1Count < 255) {
+    _int1Count++;
+  }
+  uint8_t duration = _regs[0x38] & 0x7F;
+  bool fire = hit && (_int1Count >= (duration ? duration : 1));
+
+  if (cfg & 0x40) {
+    /* Latched until INT1_SRC is read */
+    if (fire && !(_regs[0x31] & 0x40)) {
+      _regs[0x31] = 0x40 | events;
+    }
+  } else {
+    _regs[0x31] = fire ? (0x40 | events) : 0;
+  }
+  if (fire && ((_regs[0x21] & 0x30) == 0x30)) {
+    _hpReset = true; // autoreset high-pass mode
+  }
+}
+
+void L3GD20Model::produce(uint64_t t_ns) {
+  simSignal_t in = _func ? _func(t_ns, _context) : _constant;
+  float dps[3] = {in.x, in.y, in.z};
+  highPass(dps);
+  float sensitivity = sensitivityMdps[(_regs[0x23] >> 4) & 0x03];
+  uint8_t axes = _regs[0x20] & 0x07;
+  bool turningOn = t_ns < _validFrom;
+
+  if (turningOn) {
+    samplesTurnOn++;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    if (!(axes & (1 << i))) {
+      continue;
+    }
+    float counts = turningOn ? (float)SIM_TURN_ON_COUNTS
+                             : roundf(dps[i] * 1000.0F / sensitivity);
+    if (counts > 32767.0F) {
+      counts = 32767.0F;
+    } else if (counts < -32768.0F) {
+      counts = -32768.0F;
+    }
+    _out[i] = (int16_t)counts;
+  }
+  thresholdEvents();
+  _regs[0x26] = (uint8_t)in.temperature;
+  _sampleTimes[samplesGenerated & 63] = t_ns;
+  samplesGenerated++;
+
+  if (fifoActive()) {
+    if (_fifoCount == 32) {
+      samplesLost++;
+      if ((_regs[0x2E] >> 5) == 1) {
+        return; // FIFO mode stops collecting when full
+      }
+      _fifoHead = (_fifoHead + 1) & 31;
+      _fifoCount--;
+    }
+    uint8_t tail = (_fifoHead + _fifoCount) & 31;
+    memcpy(_fifo[tail], _out, sizeof(_out));
+    _fifoCount++;
+  }
+
+  /* STATUS_REG: xDA bits 2..0, ZYXDA bit 3, xOR bits 6..4, ZYXOR bit 7 */
+  uint8_t status = _regs[0x27];
+  uint8_t overrun = (status & axes) << 4;
+  if ((status & 0x08) && !fifoActive()) {
+    samplesLost++;
+  }
+  status |= axes | 0x08 | overrun;
+  if (status & 0x70) {
+    status |= 0x80;
+  }
+  _regs[0x27] = status;
+}
+
+uint8_t L3GD20Model::readRegister(uint8_t reg) {
+  if ((reg >= 0x28) && (reg <= 0x2D)) {
+    uint8_t axis = (reg - 0x28) >> 1;
+    int16_t value = _out[axis];
+    if (fifoActive() && (_fifoCount > 0)) {
+      value = _fifo[_fifoHead][axis];
+      if (reg == 0x2D) {
+        memcpy(_out, _fifo[_fifoHead], sizeof(_out));
+        _fifoHead = (_fifoHead + 1) & 31;
+        _fifoCount--;
+      }
+    }
+    if (reg & 0x01) {
+      /* Reading the high byte consumes the axis */
+      uint8_t status = _regs[0x27] & ~((1 << axis) | (0x10 << axis));
+      if (!(status & 0x07)) {
+        status &= ~0x08;
+      }
+      if (!(status & 0x70)) {
+        status &= ~0x80;
+      }
+      _regs[0x27] = status;
+      return (uint8_t)((uint16_t)value >> 8);
+    }
+    return (uint8_t)(value & 0xFF);
+  }
+
+  if ((reg == 0x25) && ((_regs[0x21] & 0x30) == 0x00)) {
+    /* Reading REFERENCE resets the filter in normal-reset mode */
+    _hpReset = true;
+  }
+
+  if (reg == 0x31) {
+    uint8_t src = _regs[0x31];
+    if (_regs[0x30] & 0x40) {
+      _regs[0x31] = 0; // reading clears a latched request
+    }
+    return src;
+  }
+
+  if (reg == 0x2F) {
+    uint8_t wtm = _regs[0x2E] & 0x1F;
+    uint8_t src = (_fifoCount == 32) ? 0x1F : _fifoCount;
+    if ((_fifoCount > 0) && (_fifoCount >= wtm)) {
+      src |= 0x80;
+    }
+    if (_fifoCount == 32) {
+      src |= 0x40;
+    }
+    if (_fifoCount == 0) {
+      src |= 0x20;
+    }
+    return src;
+  }
+
+  return _regs[reg];
+}
+
+void L3GD20Model::writeRegister(uint8_t reg, uint8_t value) {
+  switch (reg) {
+  case 0x0F:
+  case 0x26:
+  case 0x27:
+  case 0x28:
+  case 0x29:
+  case 0x2A:
+  case 0x2B:
+  case 0x2C:
+  case 0x2D:
+  case 0x2F:
+  case 0x31:
+    return; // read-only
+  case 0x24:
+    value &= 0x7F; // BOOT clears itself once the trimming is reloaded
+    if (!(value & 0x40)) {
+      _fifoCount = 0;
+    }
+    break;
+  case 0x30:
+    _int1Count = 0;
+    break;
+  case 0x2E:
+    if ((value >> 5) == 0) {
+      _fifoCount = 0; // bypass resets the FIFO
+    }
+    break;
+  default:
+    if ((reg > 0x38) && (_variant == SIM_L3GD20)) {
+      return; // reserved on the original part
+    }
+    break;
+  }
+  if (reg == 0x20) {
+    update(); // account the time before the write to the old mode
+  }
+  _regs[reg] = value;
+  if (reg == 0x20) {
+    update(); // power state changes take effect at the write
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the register address for the next read() or write()
+    @param  reg           Register address
+    @param  autoIncrement Whether the address advances after each byte
+*/
+/**************************************************************************/
+void L3GD20Model::select(uint8_t reg, bool autoIncrement) {
+  update();
+  _pointer = reg & 0x3F;
+  _autoIncrement = autoIncrement;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the register at the current address
+    @return The register value
+*/
+/**************************************************************************/
+uint8_t L3GD20Model::read(void) {
+  uint8_t value = readRegister(_pointer);
+  if (_autoIncrement) {
+    /* The output window rolls over while the FIFO is enabled */
+    if ((_pointer == 0x2D) && (_regs[0x24] & 0x40)) {
+      _pointer = 0x28;
+    } else {
+      _pointer = (_pointer + 1) & 0x3F;
+    }
+  }
+  return value;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes the register at the current address
+    @param  value The value to write
+*/
+/**************************************************************************/
+void L3GD20Model::write(uint8_t value) {
+  writeRegister(_pointer, value);
+  if (_autoIncrement) {
+    _pointer = (_pointer + 1) & 0x3F;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the level of the INT1 pin
+    @return True when INT1 is asserted
+*/
+/**************************************************************************/
+bool L3GD20Model::int1(void) {
+  update();
+  bool asserted = (_regs[0x22] & 0x80) && (_regs[0x31] & 0x40);
+  /* H_Lactive makes the pin active low */
+  return (_regs[0x22] & 0x20) ? !asserted : asserted;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the level of the DRDY/INT2 pin
+    @return True when DRDY/INT2 is asserted
+*/
+/**************************************************************************/
+bool L3GD20Model::int2(void) {
+  update();
+  uint8_t ctrl3 = _regs[0x22];
+  uint8_t wtm = _regs[0x2E] & 0x1F;
+
+  if ((ctrl3 & 0x08) && (_regs[0x27] & 0x08)) {
+    return true;
+  }
+  if ((ctrl3 & 0x04) && (_fifoCount > 0) && (_fifoCount >= wtm)) {
+    return true;
+  }
+  if ((ctrl3 & 0x02) && (_fifoCount == 32)) {
+    return true;
+  }
+  if ((ctrl3 & 0x01) && (_fifoCount == 0)) {
+    return true;
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads a register without any read side effects
+    @param  reg Register address
+    @return The register value
+*/
+/**************************************************************************/
+uint8_t L3GD20Model::peek(uint8_t reg) {
+  update();
+  return _regs[reg & 0x3F];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of samples held in the FIFO
+    @return The FIFO level
+*/
+/**************************************************************************/
+uint8_t L3GD20Model::fifoLevel(void) {
+  update();
+  return _fifoCount;
+}
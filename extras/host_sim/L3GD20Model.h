@@ -0,0 +1,112 @@
+/*!
+ * @file L3GD20Model.h
+ *
+ * Register-file model of the L3GD20 and L3GD20H gyroscopes for the host
+ * simulator. Samples are generated at the configured output data rate from
+ * an injected angular rate signal, using the simulated clock.
+ */
+
+#ifndef __L3GD20_MODEL_H__
+#define __L3GD20_MODEL_H__
+
+#include <Arduino.h>
+
+/** Chip variants the model can emulate */
+typedef enum {
+  SIM_L3GD20, ///< Original L3GD20, WHO_AM_I 0xD4
+  SIM_L3GD20H ///< L3GD20H, WHO_AM_I 0xD7
+} simVariant_t;
+
+/** Power modes, indexes into L3GD20Model::modeNs */
+typedef enum {
+  SIM_POWER_NORMAL, ///< PD set, at least one axis enabled
+  SIM_POWER_SLEEP,  ///< PD set, every axis disabled
+  SIM_POWER_DOWN    ///< PD clear
+} simPowerMode_t;
+
+/** Raw value output on every axis while the sensor is turning on */
+#define SIM_TURN_ON_COUNTS (23130)
+
+/** Angular rate and die temperature injected at one instant */
+typedef struct {
+  float x;            ///< X axis rate in degrees/s
+  float y;            ///< Y axis rate in degrees/s
+  float z;            ///< Z axis rate in degrees/s
+  int8_t temperature; ///< Raw OUT_TEMP value
+} simSignal_t;
+
+/** Signal source: returns the input seen by the sensor at time 't_ns' */
+typedef simSignal_t (*simSignalFunc_t)(uint64_t t_ns, void *context);
+
+/*!
+ * @brief Simulated L3GD20 / L3GD20H register file
+ */
+class L3GD20Model {
+public:
+  L3GD20Model(simVariant_t variant = SIM_L3GD20);
+
+  void reset(void);
+  void setSignal(float x, float y, float z, int8_t temperature = 25);
+  void setSignal(simSignalFunc_t func, void *context = NULL);
+  void setRateError(int32_t ppm);
+  void setTurnOnTime(uint32_t sleepNs, uint32_t powerDownNs);
+
+  /* Register interface used by the bus models */
+  void select(uint8_t reg, bool autoIncrement);
+  uint8_t read(void);
+  void write(uint8_t value);
+
+  /* Pins and internals for the harness */
+  bool int1(void);
+  bool int2(void);
+  uint8_t peek(uint8_t reg);
+  uint8_t fifoLevel(void);
+  uint32_t samplePeriodNs(void);
+  uint64_t sampleTimeNs(uint32_t index);
+  void update(void);
+
+  uint32_t samplesGenerated; ///< Samples produced since reset()
+  uint32_t samplesLost;      ///< Samples overwritten before being read
+  uint32_t samplesTurnOn;    ///< Samples taken while turning on
+  uint64_t modeNs[3];        ///< Time spent in each simPowerMode_t
+
+private:
+  bool active(void);
+  simPowerMode_t powerMode(void);
+  bool fifoActive(void);
+  void produce(uint64_t t_ns);
+  void highPass(float *dps);
+  void thresholdEvents(void);
+  uint8_t readRegister(uint8_t reg);
+  void writeRegister(uint8_t reg, uint8_t value);
+
+  simVariant_t _variant;
+  uint8_t _regs[0x40];
+  uint8_t _pointer;
+  bool _autoIncrement;
+
+  simSignal_t _constant;
+  simSignalFunc_t _func;
+  void *_context;
+  int32_t _ppm;
+  uint64_t _nextSample;
+  bool _wasActive;
+  bool _wasPoweredDown;
+  uint32_t _sleepTurnOnNs;
+  uint32_t _powerDownTurnOnNs;
+  uint64_t _validFrom;
+  uint64_t _modeSince;
+
+  uint64_t _sampleTimes[64];
+  float _hpIn[3];
+  float _hpOut[3];
+  bool _hpActive;
+  bool _hpReset;
+  uint8_t _int1Count;
+  int16_t _out[3];
+  int16_t _fifo[32][3];
+  uint8_t _fifoHead;
+  uint8_t _fifoCount;
+};
+
+#endif
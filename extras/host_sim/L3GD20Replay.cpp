@@ -0,0 +1,194 @@
+/*!
+ * @file L3GD20Replay.cpp
+ *
+ * Bus capture and replay for the host simulator.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "L3GD20Replay.h"
+
+/**************************************************************************/
+/*!
+    @brief  Instantiates an empty capture
+*/
+/**************************************************************************/
+L3GD20Capture::L3GD20Capture(void) : data(NULL), size(0), _capacity(0) {}
+
+L3GD20Capture::~L3GD20Capture(void) { free(data); }
+
+/**************************************************************************/
+/*!
+    @brief  Appends a piece of a record, for
+            Adafruit_L3GD20_Unified::setBusCapture()
+    @param  record  The bytes to append
+    @param  length  The length of 'record'
+    @param  context The L3GD20Capture to append to
+*/
+/**************************************************************************/
+void L3GD20Capture::record(const uint8_t *record, uint8_t length,
+                           void *context) {
+  ((L3GD20Capture *)context)->append(record, length);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Drops every record
+*/
+/**************************************************************************/
+void L3GD20Capture::clear(void) { size = 0; }
+
+/**************************************************************************/
+/*!
+    @brief  Writes the capture to a file
+    @param  path    The file to write
+    @return True if the whole capture was written
+*/
+/**************************************************************************/
+bool L3GD20Capture::save(const char *path) {
+  FILE *out = fopen(path, "wb");
+  if (out == NULL) {
+    return false;
+  }
+  bool ok = fwrite(data, 1, size, out) == size;
+  return (fclose(out) == 0) && ok;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Replaces the capture with the contents of a file
+    @param  path    The file to read, e.g. as logged on the target
+    @return True if the file was read
+*/
+/**************************************************************************/
+bool L3GD20Capture::load(const char *path) {
+  FILE *in = fopen(path, "rb");
+  if (in == NULL) {
+    return false;
+  }
+  uint8_t chunk[4096];
+  size_t n;
+  bool ok = true;
+
+  clear();
+  while (ok && ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)) {
+    ok = append(chunk, n);
+  }
+  ok = ok && !ferror(in);
+  fclose(in);
+  return ok;
+}
+
+bool L3GD20Capture::append(const uint8_t *bytes, size_t length) {
+  if (size + length > _capacity) {
+    size_t capacity = _capacity ? _capacity : 4096;
+    while (capacity < size + length) {
+      capacity *= 2;
+    }
+    uint8_t *grown = (uint8_t *)realloc(data, capacity);
+    if (grown == NULL) {
+      return false;
+    }
+    data = grown;
+    _capacity = capacity;
+  }
+  memcpy(data + size, bytes, length);
+  size += length;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Prepares to replay a capture, with its first gap measured from
+            now
+    @param  data    The records, which must outlive the replay
+    @param  size    The bytes in 'data'
+*/
+/**************************************************************************/
+L3GD20Replay::L3GD20Replay(const uint8_t *data, size_t size)
+    : _data(data), _size(size) {
+  rewind();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Answers one transaction, for
+            Adafruit_L3GD20_Unified::setBusReplay()
+    @param  op      The transaction the driver makes
+    @param  reg     The register it addresses
+    @param  data    The bytes written, or the placeholder for those read
+    @param  length  The bytes requested or written; receives the bytes
+                    replayed
+    @param  context The L3GD20Replay to answer from
+    @return The recorded outcome, false once the capture is exhausted
+*/
+/**************************************************************************/
+bool L3GD20Replay::replay(gyroBusOp_t op, uint8_t reg, uint8_t *data,
+                          uint8_t *length, void *context) {
+  return ((L3GD20Replay *)context)->next(op, reg, data, length);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts over at the first record, with its gap measured from now
+*/
+/**************************************************************************/
+void L3GD20Replay::rewind(void) {
+  _position = 0;
+  _endUs = SimClock::now() / 1000;
+  records = 0;
+  mismatches = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Tells whether every record has been replayed
+    @return True at the end of the capture
+*/
+/**************************************************************************/
+bool L3GD20Replay::finished(void) { return _position >= _size; }
+
+bool L3GD20Replay::next(gyroBusOp_t op, uint8_t reg, uint8_t *data,
+                        uint8_t *length) {
+  gyroBusRecord_t record;
+  size_t used = l3gd20ParseCapture(_data + _position, _size - _position,
+                                   &record);
+  if (used == 0) {
+    /* Exhausted or corrupt: the driver sees a dead bus */
+    mismatches++;
+    *length = 0;
+    return false;
+  }
+  _position += used;
+  records++;
+
+  /* The driver should ask for exactly what it asked for back then */
+  bool match = (record.op == op) && (record.reg == reg);
+  if (op == GYRO_BUS_WRITE) {
+    match = match && (record.length == *length) &&
+            (memcmp(record.data, data, *length) == 0);
+  } else if (record.length > *length) {
+    match = false;
+  }
+  if (!match) {
+    mismatches++;
+  }
+
+  /* Recreate the recorded timing on the simulated clock */
+  uint64_t start = _endUs + record.gap;
+  if (SimClock::now() < start * 1000) {
+    SimClock::advance(start * 1000 - SimClock::now());
+  }
+  uint64_t end = SimClock::now() / 1000 + record.duration;
+  SimClock::advance(end * 1000 - SimClock::now());
+  _endUs = end;
+
+  if (op != GYRO_BUS_WRITE) {
+    uint8_t n = (record.length < *length) ? record.length : *length;
+    memcpy(data, record.data, n);
+    *length = n;
+  }
+  return record.ok;
+}
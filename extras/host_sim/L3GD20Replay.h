@@ -0,0 +1,65 @@
+/*!
+ * @file L3GD20Replay.h
+ *
+ * Bus capture and replay for the host simulator. L3GD20Capture collects
+ * the records of Adafruit_L3GD20_Unified::setBusCapture() in memory and
+ * saves or loads them as a file; L3GD20Replay feeds them back through
+ * setBusReplay(), moving the simulated clock to the recorded times, so the
+ * driver makes the same decisions it made when the capture was taken.
+ * Requires L3GD20_BUS_REPLAY, which the Makefile defines.
+ */
+
+#ifndef __L3GD20_REPLAY_H__
+#define __L3GD20_REPLAY_H__
+
+#include <Adafruit_L3GD20_U.h>
+
+/*!
+ * @brief Growing in-memory bus capture
+ */
+class L3GD20Capture {
+public:
+  L3GD20Capture(void);
+  ~L3GD20Capture(void);
+
+  static void record(const uint8_t *record, uint8_t length, void *context);
+  void clear(void);
+  bool save(const char *path);
+  bool load(const char *path);
+
+  uint8_t *data; ///< Records back to back
+  size_t size;   ///< Bytes in 'data'
+
+private:
+  L3GD20Capture(const L3GD20Capture &);
+  L3GD20Capture &operator=(const L3GD20Capture &);
+  bool append(const uint8_t *bytes, size_t length);
+
+  size_t _capacity;
+};
+
+/*!
+ * @brief Answers the driver's bus transactions from a capture
+ */
+class L3GD20Replay {
+public:
+  L3GD20Replay(const uint8_t *data, size_t size);
+
+  static bool replay(gyroBusOp_t op, uint8_t reg, uint8_t *data,
+                     uint8_t *length, void *context);
+  void rewind(void);
+  bool finished(void);
+
+  uint32_t records;    ///< Transactions replayed
+  uint32_t mismatches; ///< Transactions that differ from the capture
+
+private:
+  bool next(gyroBusOp_t op, uint8_t reg, uint8_t *data, uint8_t *length);
+
+  const uint8_t *_data;
+  size_t _size;
+  size_t _position;
+  uint64_t _endUs;
+};
+
+#endif
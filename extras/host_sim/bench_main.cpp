@@ -0,0 +1,427 @@
+/*!
+ * @file bench_main.cpp
+ *
+ * Measures the cost of each driver read path against the simulated bus.
+ * For every delivered sample it reports the I2C transactions, bytes on the
+ * wire, retries, simulated bus time and host CPU time spent in the driver
+ * itself (time inside the bus model is subtracted).
+ *
+ *   make bench [BENCH_SAMPLES=n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <Adafruit_L3GD20_U.h>
+#include <SPI.h>
+
+#include "L3GD20Model.h"
+
+static uint32_t benchSamples = 20000;
+
+static uint64_t hostNow(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Accumulates the measured sections of one benchmark case */
+class BenchCase {
+public:
+  BenchCase(const char *name, simBusStats_t &bus = Wire.stats)
+      : _name(name), _stats(bus) {
+    _samples = 0;
+    _hostNs = 0;
+    _simNs = 0;
+    memset(&_bus, 0, sizeof(_bus));
+  }
+
+  void start(void) {
+    _busStart = _stats;
+    _simStart = SimClock::now();
+    _hostStart = hostNow();
+  }
+
+  void stop(size_t samples) {
+    _hostNs += hostNow() - _hostStart;
+    _simNs += SimClock::now() - _simStart;
+    _samples += samples;
+    _bus.transactions += _stats.transactions - _busStart.transactions;
+    _bus.bytesWritten += _stats.bytesWritten - _busStart.bytesWritten;
+    _bus.bytesRead += _stats.bytesRead - _busStart.bytesRead;
+    _bus.nacks += _stats.nacks - _busStart.nacks;
+    _bus.hostNs += _stats.hostNs - _busStart.hostNs;
+  }
+
+  void report(void) {
+    const simBusStats_t &bus = _bus;
+    double n = _samples ? _samples : 1;
+    printf("%-32s %8.2f %8.2f %8.3f %9.1f %9.1f\n", _name,
+           bus.transactions / n, (bus.bytesWritten + bus.bytesRead) / n,
+           bus.nacks / n, _simNs / n / 1000.0,
+           (double)(_hostNs - bus.hostNs) / n);
+  }
+
+private:
+  const char *_name;
+  simBusStats_t &_stats;
+  uint32_t _samples;
+  uint64_t _hostNs;
+  uint64_t _hostStart;
+  uint64_t _simNs;
+  uint64_t _simStart;
+  simBusStats_t _bus;
+  simBusStats_t _busStart;
+};
+
+static void setup(L3GD20Model &model) {
+  Wire = TwoWire();
+  Wire.setClock(400000);
+  Wire.attach(L3GD20_ADDRESS, &model);
+  SimClock::reset();
+  model.setSignal(12.0F, -34.0F, 56.0F);
+}
+
+static void benchGetEvent(uint32_t nackEvery) {
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+
+  setup(model);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+
+  BenchCase bench(nackEvery ? "getEvent() 1 NACK per 10" : "getEvent()");
+  for (uint32_t i = 0; i < benchSamples; i++) {
+    delayMicroseconds(gyro.getSamplePeriod());
+    if (nackEvery && ((i % nackEvery) == 0)) {
+      Wire.nackNext(1);
+    }
+    bench.start();
+    gyro.getEvent(&event);
+    bench.stop(1);
+  }
+  bench.report();
+}
+
+static void benchYaw(void) {
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+
+  setup(model);
+  gyro.setAxes(GYRO_AXIS_Z);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+
+  BenchCase bench("getEvent() Z only");
+  for (uint32_t i = 0; i < benchSamples; i++) {
+    delayMicroseconds(gyro.getSamplePeriod());
+    bench.start();
+    gyro.getEvent(&event);
+    bench.stop(1);
+  }
+  bench.report();
+}
+
+static void benchStatusRead(void) {
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+
+  setup(model);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  gyro.enableStatusRead(true);
+
+  BenchCase bench("getEvent() status read");
+  for (uint32_t i = 0; i < benchSamples; i++) {
+    delayMicroseconds(gyro.getSamplePeriod());
+    bench.start();
+    gyro.getEvent(&event);
+    bench.stop(1);
+  }
+  bench.report();
+}
+
+static void benchAutoRange(void) {
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+
+  setup(model);
+  model.setSignal(1500.0F, 0, 0);
+  gyro.enableAutoRange(true);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+
+  BenchCase bench("getEvent() auto-range step");
+  for (uint32_t i = 0; i < benchSamples / 10; i++) {
+    gyro.begin(GYRO_RANGE_250DPS);
+    delayMicroseconds(gyro.getSamplePeriod());
+    bench.start();
+    gyro.getEvent(&event);
+    bench.stop(1);
+  }
+  bench.report();
+}
+
+static void benchReadFifo(void) {
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+
+  setup(model);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+
+  BenchCase bench("readFifo() 24 deep");
+  for (uint32_t done = 0; done < benchSamples;) {
+    delayMicroseconds(gyro.getSamplePeriod() * 24);
+    bench.start();
+    size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+    bench.stop(count);
+    done += count;
+  }
+  bench.report();
+}
+
+static void benchInterrupt(void) {
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  gyroRawData_t ring[64];
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+
+  setup(model);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  gyro.attachSampleBuffer(ring, 64);
+  gyro.enableFifo(GYRO_FIFO_STREAM, 16);
+  gyro.enableInterrupts(false, true);
+
+  BenchCase bench("handleInterrupt() WTM 16");
+  for (uint32_t done = 0; done < benchSamples;) {
+    while (!model.int2()) {
+      delayMicroseconds(100);
+    }
+    bench.start();
+    gyro.handleInterrupt();
+    size_t count = gyro.readSamples(samples, L3GD20_FIFO_SIZE);
+    bench.stop(count);
+    done += count;
+  }
+  bench.report();
+}
+
+static void benchSpi(void) {
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro(10, &SPI);
+  sensors_event_t event;
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+
+  SPI = SPIClass();
+  SPI.attach(10, &model);
+  SimClock::reset();
+  model.setSignal(12.0F, -34.0F, 56.0F);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+
+  BenchCase single("SPI getEvent()", SPI.stats);
+  for (uint32_t i = 0; i < benchSamples; i++) {
+    delayMicroseconds(gyro.getSamplePeriod());
+    single.start();
+    gyro.getEvent(&event);
+    single.stop(1);
+  }
+  single.report();
+
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  BenchCase fifo("SPI readFifo() 24 deep", SPI.stats);
+  for (uint32_t done = 0; done < benchSamples;) {
+    delayMicroseconds(gyro.getSamplePeriod() * 24);
+    fifo.start();
+    size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+    fifo.stop(count);
+    done += count;
+  }
+  fifo.report();
+}
+
+static void benchCore(void) {
+  L3GD20Model model;
+  Adafruit_L3GD20_Core<Adafruit_L3GD20_I2C> i2c((Adafruit_L3GD20_I2C()));
+  Adafruit_L3GD20_Core<Adafruit_L3GD20_SPI> spi(Adafruit_L3GD20_SPI(10));
+  gyroRawData_t sample;
+
+  setup(model);
+  i2c.begin(GYRO_RANGE_250DPS, GYRO_DATARATE_760HZ);
+  BenchCase onI2c("Core<I2C> read()");
+  for (uint32_t i = 0; i < benchSamples; i++) {
+    delayMicroseconds(1316);
+    onI2c.start();
+    i2c.read(&sample);
+    onI2c.stop(1);
+  }
+  onI2c.report();
+
+  SPI = SPIClass();
+  SPI.attach(10, &model);
+  spi.begin(GYRO_RANGE_250DPS, GYRO_DATARATE_760HZ);
+  BenchCase onSpi("Core<SPI> read()", SPI.stats);
+  for (uint32_t i = 0; i < benchSamples; i++) {
+    delayMicroseconds(1316);
+    onSpi.start();
+    spi.read(&sample);
+    onSpi.stop(1);
+  }
+  onSpi.report();
+
+  Adafruit_L3GD20_Fixed<Adafruit_L3GD20_I2C, GYRO_RANGE_250DPS,
+                        GYRO_VARIANT_L3GD20, GYRO_DATARATE_760HZ>
+      fixed((Adafruit_L3GD20_I2C()));
+  sensors_event_t event;
+
+  setup(model);
+  fixed.begin();
+  BenchCase onFixed("Fixed<I2C> getEvent()");
+  for (uint32_t i = 0; i < benchSamples; i++) {
+    delayMicroseconds(1316);
+    onFixed.start();
+    fixed.getEvent(&event);
+    onFixed.stop(1);
+  }
+  onFixed.report();
+}
+
+static void benchConvert(bool soa) {
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  float out[3 * L3GD20_FIFO_SIZE];
+
+  setup(model);
+  gyro.begin(GYRO_RANGE_500DPS);
+  for (uint8_t i = 0; i < L3GD20_FIFO_SIZE; i++) {
+    samples[i].x = i * 3;
+    samples[i].y = -i * 5;
+    samples[i].z = i * 7;
+  }
+
+  BenchCase bench(soa ? "convertSamples() SoA x32"
+                      : "convertSamples() AoS x32");
+  for (uint32_t done = 0; done < benchSamples; done += L3GD20_FIFO_SIZE) {
+    bench.start();
+    if (soa) {
+      gyro.convertSamples(samples, out, out + L3GD20_FIFO_SIZE,
+                          out + 2 * L3GD20_FIFO_SIZE, L3GD20_FIFO_SIZE);
+    } else {
+      gyro.convertSamples(samples, out, L3GD20_FIFO_SIZE);
+    }
+    bench.stop(L3GD20_FIFO_SIZE);
+    __asm__ __volatile__("" : : "r"(out) : "memory");
+  }
+  bench.report();
+}
+
+static void benchAttitude(bool fixed) {
+  Adafruit_L3GD20_Attitude attitude;
+  Adafruit_L3GD20_AttitudeFixed attitudeFixed;
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  uint32_t stamps[L3GD20_FIFO_SIZE];
+  uint32_t now = 0;
+
+  for (uint8_t i = 0; i < L3GD20_FIFO_SIZE; i++) {
+    samples[i].x = i * 3;
+    samples[i].y = -i * 5;
+    samples[i].z = i * 7;
+  }
+
+  BenchCase bench(fixed ? "AttitudeFixed update() x32"
+                        : "Attitude update() x32");
+  for (uint32_t done = 0; done < benchSamples; done += L3GD20_FIFO_SIZE) {
+    for (uint8_t i = 0; i < L3GD20_FIFO_SIZE; i++) {
+      stamps[i] = now += 1316;
+    }
+    bench.start();
+    if (fixed) {
+      attitudeFixed.update(samples, stamps, L3GD20_FIFO_SIZE,
+                           GYRO_RANGE_500DPS);
+    } else {
+      attitude.update(samples, stamps, L3GD20_FIFO_SIZE, GYRO_SCALE_500DPS);
+    }
+    bench.stop(L3GD20_FIFO_SIZE);
+  }
+  bench.report();
+}
+
+static void benchStream(void) {
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  uint32_t stamps[L3GD20_FIFO_SIZE];
+  uint8_t frame[L3GD20_STREAM_MAX_FRAME];
+  uint32_t now = 0;
+
+  for (uint8_t i = 0; i < L3GD20_FIFO_SIZE; i++) {
+    samples[i].x = 1000 + i * 300;
+    samples[i].y = -i * 50;
+    samples[i].z = i & 3;
+  }
+
+  BenchCase bench("l3gd20EncodeFrame() x32");
+  for (uint32_t done = 0; done < benchSamples; done += L3GD20_FIFO_SIZE) {
+    for (uint8_t i = 0; i < L3GD20_FIFO_SIZE; i++) {
+      stamps[i] = now += 1316;
+    }
+    bench.start();
+    size_t len = l3gd20EncodeFrame(frame, sizeof(frame), samples, stamps,
+                                   L3GD20_FIFO_SIZE, GYRO_RANGE_500DPS);
+    bench.stop(L3GD20_FIFO_SIZE);
+    __asm__ __volatile__("" : : "r"(frame), "r"(len) : "memory");
+  }
+  bench.report();
+}
+
+static void benchLegacy(void) {
+  L3GD20Model model;
+  Adafruit_L3GD20 gyro;
+
+  setup(model);
+  gyro.begin();
+
+  BenchCase bench("Adafruit_L3GD20::read()");
+  for (uint32_t i = 0; i < benchSamples; i++) {
+    delayMicroseconds(10526);
+    bench.start();
+    gyro.read();
+    bench.stop(1);
+  }
+  bench.report();
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    benchSamples = strtoul(argv[1], NULL, 0);
+  }
+
+  printf("%u samples per case, I2C at 400 kHz, SPI at 10 MHz\n\n",
+         (unsigned)benchSamples);
+  printf("%-32s %8s %8s %8s %9s %9s\n", "per sample", "xfers", "bytes",
+         "retries", "bus us", "drv ns");
+  benchGetEvent(0);
+  benchGetEvent(10);
+  benchStatusRead();
+  benchYaw();
+  benchAutoRange();
+  benchReadFifo();
+  benchInterrupt();
+  benchSpi();
+  benchCore();
+  benchConvert(false);
+  benchConvert(true);
+  benchAttitude(false);
+  benchAttitude(true);
+  benchStream();
+  benchLegacy();
+
+  return 0;
+}
@@ -0,0 +1,47 @@
+/*!
+ * @file decode_main.cpp
+ *
+ * Turns a binary sample stream, as written with l3gd20EncodeFrame(), back
+ * into rad/s. Reads a capture file or stdin and prints one CSV line per
+ * sample; bad frames are counted on stderr.
+ *
+ *   ./l3gd20_decode [capture.bin] > samples.csv
+ */
+
+#include <stdio.h>
+
+#include <Adafruit_L3GD20_U.h>
+
+int main(int argc, char **argv) {
+  FILE *in = stdin;
+  if (argc > 1) {
+    in = fopen(argv[1], "rb");
+    if (in == NULL) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  Adafruit_L3GD20_StreamDecoder decoder;
+  float rates[3 * L3GD20_STREAM_MAX_SAMPLES];
+  uint32_t samples = 0;
+  int c;
+
+  printf("time_us,x_rads,y_rads,z_rads,range_dps\n");
+  while ((c = getc(in)) != EOF) {
+    if (!decoder.feed((uint8_t)c)) {
+      continue;
+    }
+    decoder.convertSamples(rates);
+    for (uint8_t i = 0; i < decoder.count; i++) {
+      printf("%u,%.6f,%.6f,%.6f,%d\n", (unsigned)decoder.timestamps[i],
+             rates[3 * i], rates[3 * i + 1], rates[3 * i + 2],
+             (int)decoder.range);
+    }
+    samples += decoder.count;
+  }
+
+  fprintf(stderr, "%u samples, %u bad frames\n", (unsigned)samples,
+          (unsigned)decoder.errors);
+  return 0;
+}
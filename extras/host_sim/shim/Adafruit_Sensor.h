@@ -0,0 +1,75 @@
+/*!
+ * @file Adafruit_Sensor.h
+ *
+ * Host stand-in for the parts of the Adafruit Unified Sensor library the
+ * L3GD20 driver uses. Layouts match the real library.
+ */
+
+#ifndef _ADAFRUIT_SENSOR_H
+#define _ADAFRUIT_SENSOR_H
+
+#include "Arduino.h"
+
+#define SENSORS_DPS_TO_RADS (0.017453293F) ///< Degrees/s to rad/s multiplier
+#define SENSORS_RADS_TO_DPS (57.29577793F) ///< Rad/s to degrees/s multiplier
+
+/** Sensor types */
+typedef enum {
+  SENSOR_TYPE_GYROSCOPE = (4) ///< Gyroscope
+} sensors_type_t;
+
+/** Struct to hold a 3-axis vector */
+typedef struct {
+  union {
+    float v[3]; ///< 3D vector elements
+    struct {
+      float x; ///< X component
+      float y; ///< Y component
+      float z; ///< Z component
+    };
+  };
+  int8_t status;       ///< Status byte
+  uint8_t reserved[3]; ///< Reserved
+} sensors_vec_t;
+
+/** Sensor event (36 bytes) */
+typedef struct {
+  int32_t version;   ///< must be sizeof(struct sensors_event_t)
+  int32_t sensor_id; ///< unique sensor identifier
+  int32_t type;      ///< sensor type
+  int32_t reserved0; ///< reserved
+  int32_t timestamp; ///< time is in milliseconds
+  union {
+    float data[4];      ///< Raw data
+    sensors_vec_t gyro; ///< gyroscope values are in rad/s
+    float temperature;  ///< temperature is in degrees centigrade
+  };
+} sensors_event_t;
+
+/** Sensor details (40 bytes) */
+typedef struct {
+  char name[12];     ///< sensor name
+  int32_t version;   ///< version of the hardware + driver
+  int32_t sensor_id; ///< unique sensor identifier
+  int32_t type;      ///< this sensor's type
+  float max_value;   ///< maximum value of this sensor's value in SI units
+  float min_value;   ///< minimum value of this sensor's value in SI units
+  float resolution;  ///< smallest difference between two values
+  int32_t min_delay; ///< min delay in microseconds between events
+} sensor_t;
+
+/** Common sensor interface */
+class Adafruit_Sensor {
+public:
+  Adafruit_Sensor() {}
+  virtual ~Adafruit_Sensor() {}
+
+  /** Enable or disable auto-ranging */
+  virtual void enableAutoRange(bool enabled) { (void)enabled; };
+  /** Get the latest sensor event */
+  virtual bool getEvent(sensors_event_t *) = 0;
+  /** Get info about the sensor itself */
+  virtual void getSensor(sensor_t *) = 0;
+};
+
+#endif
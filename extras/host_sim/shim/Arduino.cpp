@@ -0,0 +1,69 @@
+/*!
+ * @file Arduino.cpp
+ *
+ * Simulated clock and GPIO levels for the host build.
+ */
+
+#include "Arduino.h"
+
+static uint64_t simNow = 0;
+
+uint64_t SimClock::now(void) { return simNow; }
+
+void SimClock::advance(uint64_t ns) { simNow += ns; }
+
+void SimClock::reset(uint64_t ns) { simNow = ns; }
+
+unsigned long millis(void) { return (unsigned long)(simNow / 1000000ULL); }
+
+unsigned long micros(void) { return (unsigned long)(simNow / 1000ULL); }
+
+void delay(unsigned long ms) { simNow += (uint64_t)ms * 1000000ULL; }
+
+void delayMicroseconds(unsigned int us) { simNow += (uint64_t)us * 1000ULL; }
+
+#define SIM_PINS 64
+
+static uint8_t pinLevel[SIM_PINS];
+static uint8_t pinInput[SIM_PINS];
+static uint32_t pinFalls[SIM_PINS];
+static simPinHook_t pinHook = NULL;
+static void *pinHookContext = NULL;
+
+uint8_t SimPins::level(uint8_t pin) {
+  return (pin < SIM_PINS) ? pinLevel[pin] : LOW;
+}
+
+uint32_t SimPins::fallingEdges(uint8_t pin) {
+  return (pin < SIM_PINS) ? pinFalls[pin] : 0;
+}
+
+void SimPins::setInput(uint8_t pin, uint8_t v) {
+  if (pin < SIM_PINS) {
+    pinInput[pin] = v;
+  }
+}
+
+void SimPins::setHook(simPinHook_t hook, void *context) {
+  pinHook = hook;
+  pinHookContext = context;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= SIM_PINS) {
+    return;
+  }
+  if ((pinLevel[pin] == HIGH) && (val == LOW)) {
+    pinFalls[pin]++;
+  }
+  pinLevel[pin] = val;
+  if (pinHook) {
+    pinHook(pin, val, pinHookContext);
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return (pin < SIM_PINS) ? pinInput[pin] : LOW;
+}
@@ -0,0 +1,59 @@
+/*!
+ * @file Arduino.h
+ *
+ * Minimal host stand-in for the Arduino core, used by the L3GD20 simulator.
+ * Time is simulated: it only advances through delay(), delayMicroseconds()
+ * and bus traffic, which makes every run deterministic.
+ */
+
+#ifndef __SIM_ARDUINO_H__
+#define __SIM_ARDUINO_H__
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t byte; ///< Arduino byte type
+
+#define HIGH 0x1   ///< Digital pin level high
+#define LOW 0x0    ///< Digital pin level low
+#define INPUT 0x0  ///< Pin mode input
+#define OUTPUT 0x1 ///< Pin mode output
+#define MSBFIRST 1 ///< SPI bit order
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+/*!
+ * @brief Simulated time base shared by the core shim and the bus models
+ */
+namespace SimClock {
+uint64_t now(void);          ///< Current simulated time in nanoseconds
+void advance(uint64_t ns);   ///< Moves simulated time forward
+void reset(uint64_t ns = 0); ///< Restarts simulated time
+
+} // namespace SimClock
+
+/** Called after every digitalWrite(), see SimPins::setHook() */
+typedef void (*simPinHook_t)(uint8_t pin, uint8_t val, void *context);
+
+/*!
+ * @brief Simulated GPIO levels, observed by the SPI bus models
+ */
+namespace SimPins {
+uint8_t level(uint8_t pin);            ///< Last level written to 'pin'
+uint32_t fallingEdges(uint8_t pin);    ///< HIGH to LOW transitions on 'pin'
+void setInput(uint8_t pin, uint8_t v); ///< Level digitalRead() returns
+/** Calls 'hook' after every digitalWrite(), NULL removes it */
+void setHook(simPinHook_t hook, void *context = NULL);
+
+} // namespace SimPins
+
+#endif
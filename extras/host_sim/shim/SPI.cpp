@@ -0,0 +1,145 @@
+/*!
+ * @file SPI.cpp
+ *
+ * Simulated SPI bus for the host build.
+ */
+
+#include "SPI.h"
+#include "../L3GD20Model.h"
+
+SPIClass SPI;
+
+SPIClass::SPIClass() {
+  _deviceCount = 0;
+  _clock = 4000000;
+  _inTransaction = false;
+  resetStats();
+}
+
+void SPIClass::begin(void) {}
+
+bool SPIClass::attach(uint8_t csPin, L3GD20Model *device) {
+  if (_deviceCount == 4) {
+    return false;
+  }
+  _devices[_deviceCount].cs = csPin;
+  _devices[_deviceCount].device = device;
+  _devices[_deviceCount].frame = SimPins::fallingEdges(csPin);
+  _devices[_deviceCount].read = false;
+  _deviceCount++;
+  return true;
+}
+
+void SPIClass::resetStats(void) { memset(&stats, 0, sizeof(stats)); }
+
+void SPIClass::beginTransaction(SPISettings settings) {
+  _clock = settings.clock;
+  _inTransaction = true;
+}
+
+void SPIClass::endTransaction(void) { _inTransaction = false; }
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  uint8_t result = 0xFF;
+
+  SimClock::advance(8 * 1000000000ULL / _clock);
+
+  for (uint8_t i = 0; i < _deviceCount; i++) {
+    if (SimPins::level(_devices[i].cs) != LOW) {
+      continue;
+    }
+    L3GD20Model *device = _devices[i].device;
+    uint32_t frame = SimPins::fallingEdges(_devices[i].cs);
+    if (frame != _devices[i].frame) {
+      /* First byte of a frame: RW, MS (auto-increment) and address */
+      _devices[i].frame = frame;
+      _devices[i].read = data & 0x80;
+      device->select(data & 0x3F, data & 0x40);
+      stats.transactions++;
+    } else if (_devices[i].read) {
+      result = device->read();
+      stats.bytesRead++;
+      return result;
+    } else {
+      device->write(data);
+    }
+  }
+  stats.bytesWritten++;
+
+  return result;
+}
+
+void SPIClass::transfer(void *buf, size_t count) {
+  uint8_t *bytes = (uint8_t *)buf;
+  for (size_t i = 0; i < count; i++) {
+    bytes[i] = transfer(bytes[i]);
+  }
+}
+
+SimSoftSPI::SimSoftSPI() {
+  _device = NULL;
+  frames = 0;
+  bytes = 0;
+}
+
+void SimSoftSPI::attach(uint8_t cs, uint8_t sck, uint8_t mosi, uint8_t miso,
+                        L3GD20Model *device) {
+  _cs = cs;
+  _sck = sck;
+  _mosi = mosi;
+  _miso = miso;
+  _device = device;
+  frames = 0;
+  bytes = 0;
+  SimPins::setHook(onPinWrite, this);
+}
+
+void SimSoftSPI::detach(void) {
+  SimPins::setHook(NULL);
+  _device = NULL;
+}
+
+void SimSoftSPI::onPinWrite(uint8_t pin, uint8_t val, void *context) {
+  ((SimSoftSPI *)context)->edge(pin, val);
+}
+
+void SimSoftSPI::edge(uint8_t pin, uint8_t val) {
+  if (pin == _cs) {
+    if (val == LOW) {
+      frames++;
+      _bit = 0;
+      _index = 0;
+      _read = false;
+      _out = 0xFF;
+    }
+    return;
+  }
+  if ((pin != _sck) || (SimPins::level(_cs) != LOW)) {
+    return;
+  }
+
+  if (val == LOW) {
+    /* Falling edge: shift out the next bit, fetching a new byte first */
+    if ((_bit == 0) && _read && (_index > 0)) {
+      _out = _device->read();
+    }
+    SimPins::setInput(_miso, (_out & (0x80 >> _bit)) ? HIGH : LOW);
+    return;
+  }
+
+  /* Rising edge: sample MOSI */
+  _in = (_in << 1) | (SimPins::level(_mosi) ? 1 : 0);
+  if (++_bit < 8) {
+    return;
+  }
+  _bit = 0;
+  bytes++;
+  if (_index == 0) {
+    /* RW, MS (auto-increment) and address */
+    _read = _in & 0x80;
+    _device->select(_in & 0x3F, _in & 0x40);
+  } else if (!_read) {
+    _device->write(_in);
+  }
+  _index++;
+}
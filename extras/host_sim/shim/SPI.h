@@ -0,0 +1,98 @@
+/*!
+ * @file SPI.h
+ *
+ * Host stand-in for the Arduino SPIClass. A frame starts when a device's
+ * chip select pin goes low; its first byte carries the L3GD20 address, R/W
+ * and auto-increment bits.
+ */
+
+#ifndef __SIM_SPI_H__
+#define __SIM_SPI_H__
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define SPI_MODE0 0x00 ///< CPOL 0, CPHA 0
+#define SPI_MODE3 0x03 ///< CPOL 1, CPHA 1
+
+class L3GD20Model;
+
+/** Clock, bit order and mode of an SPI transaction */
+class SPISettings {
+public:
+  SPISettings() : clock(4000000) {}
+  /** Stores the transaction settings, only the clock is used */
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+      : clock(clock) {
+    (void)bitOrder;
+    (void)dataMode;
+  }
+  uint32_t clock; ///< SCK frequency in Hz
+};
+
+/*!
+ * @brief Simulated SPI bus
+ */
+class SPIClass {
+public:
+  SPIClass();
+
+  void begin(void);
+  void beginTransaction(SPISettings settings);
+  void endTransaction(void);
+  uint8_t transfer(uint8_t data);
+  void transfer(void *buf, size_t count);
+
+  /* Simulation controls */
+  bool attach(uint8_t csPin, L3GD20Model *device);
+  void resetStats(void);
+
+  /** Frames and bytes since the last resetStats(). Each clocked byte is
+      counted once, as read if a device drove it, otherwise as written. */
+  simBusStats_t stats;
+
+private:
+  struct {
+    uint8_t cs;
+    L3GD20Model *device;
+    uint32_t frame;
+    bool read;
+  } _devices[4];
+  uint8_t _deviceCount;
+  uint32_t _clock;
+  bool _inTransaction;
+};
+
+extern SPIClass SPI; ///< Simulated SPI bus
+
+/*!
+ * @brief Simulated bit-banged SPI: decodes mode 3 frames from the GPIO
+ *        writes of a software SPI master and drives MISO through
+ *        SimPins::setInput(). Only one instance can watch the pins at a
+ *        time.
+ */
+class SimSoftSPI {
+public:
+  SimSoftSPI();
+
+  void attach(uint8_t cs, uint8_t sck, uint8_t mosi, uint8_t miso,
+              L3GD20Model *device);
+  void detach(void);
+
+  uint32_t frames; ///< Chip select frames seen since attach()
+  uint32_t bytes;  ///< Bytes clocked since attach()
+
+private:
+  static void onPinWrite(uint8_t pin, uint8_t val, void *context);
+  void edge(uint8_t pin, uint8_t val);
+
+  uint8_t _cs, _sck, _mosi, _miso;
+  L3GD20Model *_device;
+  uint8_t _bit;
+  uint8_t _in;
+  uint8_t _out;
+  uint32_t _index;
+  bool _read;
+};
+
+#endif
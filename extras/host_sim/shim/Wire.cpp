@@ -0,0 +1,172 @@
+/*!
+ * @file Wire.cpp
+ *
+ * Simulated I2C bus for the host build.
+ */
+
+#include "Wire.h"
+#include "../L3GD20Model.h"
+
+#include <time.h>
+
+/* Charges the host time spent in a bus call to stats.hostNs */
+class HostTimer {
+public:
+  HostTimer(uint64_t &total) : _total(total) { _start = hostNow(); }
+  ~HostTimer() { _total += hostNow() - _start; }
+
+private:
+  static uint64_t hostNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+  uint64_t &_total;
+  uint64_t _start;
+};
+
+TwoWire Wire;
+TwoWire Wire1;
+
+TwoWire::TwoWire() {
+  _deviceCount = 0;
+  _clock = 100000;
+  _nackCount = 0;
+  _latency = 0;
+  _txAddress = 0;
+  _txLength = 0;
+  _rxLength = 0;
+  _rxIndex = 0;
+  resetStats();
+}
+
+void TwoWire::begin(void) {}
+
+void TwoWire::setClock(uint32_t hz) { _clock = hz; }
+
+bool TwoWire::attach(uint8_t address, L3GD20Model *device) {
+  if ((_deviceCount == 4) || find(address)) {
+    return false;
+  }
+  _devices[_deviceCount].address = address;
+  _devices[_deviceCount].device = device;
+  _deviceCount++;
+  return true;
+}
+
+void TwoWire::nackNext(uint32_t count) { _nackCount = count; }
+
+/* Fixed cost added to every transaction, e.g. driver/DMA setup on the MCU */
+void TwoWire::setTransactionLatency(uint32_t ns) { _latency = ns; }
+
+void TwoWire::resetStats(void) { memset(&stats, 0, sizeof(stats)); }
+
+L3GD20Model *TwoWire::find(uint8_t address) {
+  for (uint8_t i = 0; i < _deviceCount; i++) {
+    if (_devices[i].address == address) {
+      return _devices[i].device;
+    }
+  }
+  return NULL;
+}
+
+/* START, 9 clocks per byte (data + ACK) and STOP */
+void TwoWire::busTime(uint32_t bytes) {
+  SimClock::advance(((uint64_t)bytes * 9 + 2) * 1000000000ULL / _clock +
+                    _latency);
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  HostTimer timer(stats.hostNs);
+  _txAddress = address;
+  _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t value) {
+  HostTimer timer(stats.hostNs);
+  if (_txLength == BUFFER_LENGTH) {
+    return 0;
+  }
+  _txBuffer[_txLength++] = value;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+  for (size_t i = 0; i < quantity; i++) {
+    if (!write(data[i])) {
+      return i;
+    }
+  }
+  return quantity;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  HostTimer timer(stats.hostNs);
+  (void)sendStop;
+  L3GD20Model *device = find(_txAddress);
+
+  stats.transactions++;
+  stats.bytesWritten += 1 + _txLength;
+  busTime(1 + _txLength);
+
+  if (device == NULL) {
+    stats.nacks++;
+    return 2;
+  }
+  if (_nackCount > 0) {
+    _nackCount--;
+    stats.nacks++;
+    return 2;
+  }
+  if (_txLength > 0) {
+    device->select(_txBuffer[0] & 0x7F, _txBuffer[0] & 0x80);
+    for (uint8_t i = 1; i < _txLength; i++) {
+      device->write(_txBuffer[i]);
+    }
+  }
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity,
+                             uint8_t sendStop) {
+  HostTimer timer(stats.hostNs);
+  (void)sendStop;
+  L3GD20Model *device = find(address);
+
+  _rxLength = 0;
+  _rxIndex = 0;
+  if (quantity > BUFFER_LENGTH) {
+    quantity = BUFFER_LENGTH;
+  }
+
+  stats.transactions++;
+  stats.bytesWritten++;
+  if ((device == NULL) || (_nackCount > 0)) {
+    if (_nackCount > 0) {
+      _nackCount--;
+    }
+    stats.nacks++;
+    busTime(1);
+    return 0;
+  }
+  for (uint8_t i = 0; i < quantity; i++) {
+    _rxBuffer[_rxLength++] = device->read();
+  }
+  stats.bytesRead += quantity;
+  busTime(1 + quantity);
+
+  return quantity;
+}
+
+int TwoWire::available(void) {
+  HostTimer timer(stats.hostNs);
+  return _rxLength - _rxIndex;
+}
+
+int TwoWire::read(void) {
+  HostTimer timer(stats.hostNs);
+  if (_rxIndex == _rxLength) {
+    return -1;
+  }
+  return _rxBuffer[_rxIndex++];
+}
@@ -0,0 +1,76 @@
+/*!
+ * @file Wire.h
+ *
+ * Host stand-in for the Arduino TwoWire class. Transactions are delivered
+ * to the simulated devices attached to the bus, and simulated time advances
+ * by the time the transfer would take on the wire.
+ */
+
+#ifndef __SIM_WIRE_H__
+#define __SIM_WIRE_H__
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32 ///< Receive/transmit buffer size, as on AVR
+
+class L3GD20Model;
+
+/** Transaction counters kept by each simulated bus */
+typedef struct {
+  uint32_t transactions; ///< Address phases started (writes and reads)
+  uint32_t bytesWritten; ///< Bytes sent to devices, address bytes included
+  uint32_t bytesRead;    ///< Bytes received from devices
+  uint32_t nacks;        ///< Transactions that were not acknowledged
+  uint64_t hostNs;       ///< Host CPU time spent inside the bus model
+} simBusStats_t;
+
+/*!
+ * @brief Simulated I2C bus
+ */
+class TwoWire {
+public:
+  TwoWire();
+
+  void begin(void);
+  void setClock(uint32_t hz);
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t value);
+  size_t write(const uint8_t *data, size_t quantity);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity,
+                      uint8_t sendStop = 1);
+  int available(void);
+  int read(void);
+
+  /* Simulation controls */
+  bool attach(uint8_t address, L3GD20Model *device);
+  void nackNext(uint32_t count);
+  void setTransactionLatency(uint32_t ns);
+  void resetStats(void);
+
+  simBusStats_t stats; ///< Traffic counters since the last resetStats()
+
+private:
+  L3GD20Model *find(uint8_t address);
+  void busTime(uint32_t bytes);
+
+  struct {
+    uint8_t address;
+    L3GD20Model *device;
+  } _devices[4];
+  uint8_t _deviceCount;
+  uint32_t _clock;
+  uint32_t _nackCount;
+  uint32_t _latency;
+  uint8_t _txAddress;
+  uint8_t _txBuffer[BUFFER_LENGTH];
+  uint8_t _txLength;
+  uint8_t _rxBuffer[BUFFER_LENGTH];
+  uint8_t _rxLength;
+  uint8_t _rxIndex;
+};
+
+extern TwoWire Wire;  ///< First simulated bus
+extern TwoWire Wire1; ///< Second simulated bus
+
+#endif
@@ -0,0 +1,1498 @@
+/*!
+ * @file sim_main.cpp
+ *
+ * Runs the unmodified Adafruit_L3GD20_U driver against the simulated
+ * L3GD20 / L3GD20H and checks the results of a few common scenarios.
+ * Exits with a non-zero status if any scenario fails.
+ */
+
+#include <stdio.h>
+
+#include <Adafruit_L3GD20_U.h>
+#include <SPI.h>
+
+#include "L3GD20MockBus.h"
+#include "L3GD20Model.h"
+#include "L3GD20Replay.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("  [%s] %s\n", ok ? " OK " : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+static bool near(float a, float b, float tolerance) {
+  return fabsf(a - b) <= tolerance;
+}
+
+/* Fresh sensor attached to a fresh bus for every scenario */
+static void setup(TwoWire &bus, L3GD20Model &model) {
+  bus = TwoWire();
+  bus.setClock(400000);
+  bus.attach(L3GD20_ADDRESS, &model);
+  SimClock::reset();
+}
+
+static void scenarioIdentify(void) {
+  printf("begin() on both variants\n");
+  L3GD20Model l3gd20(SIM_L3GD20);
+  L3GD20Model l3gd20h(SIM_L3GD20H);
+  Adafruit_L3GD20_Unified gyro(1);
+
+  setup(Wire, l3gd20);
+  check(gyro.begin(), "L3GD20 detected");
+  check(l3gd20.peek(0x20) == 0x0F, "CTRL_REG1 set to normal mode");
+
+  setup(Wire, l3gd20h);
+  check(gyro.begin(), "L3GD20H detected");
+
+  Wire = TwoWire();
+  check(!gyro.begin(), "missing device rejected");
+}
+
+static void scenarioGetEvent(void) {
+  printf("getEvent() with a constant 100 dps on Z\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro(2);
+  sensors_event_t event;
+
+  setup(Wire, model);
+  model.setSignal(0, -20.0F, 100.0F);
+  gyro.begin(GYRO_RANGE_250DPS);
+  delay(20);
+  gyro.getEvent(&event);
+  check(near(event.gyro.z, 100.0F * SENSORS_DPS_TO_RADS, 0.001F),
+        "Z reads 1.745 rad/s");
+  check(near(event.gyro.y, -20.0F * SENSORS_DPS_TO_RADS, 0.001F),
+        "Y reads -0.349 rad/s");
+  check(event.gyro.x == 0.0F, "X reads 0");
+
+  gyroFixedData_t fixed;
+  delay(20);
+  gyro.getEventFixed(&fixed);
+  check((fixed.z == 100004) && (fixed.y == -20002) && (fixed.x == 0),
+        "getEventFixed() reads the same rates in mdps");
+}
+
+/* 100 dps on X until 'context' ns, 400 dps after */
+static simSignal_t stepSignal(uint64_t t_ns, void *context) {
+  simSignal_t in = {0, 0, 0, 25};
+  in.x = (t_ns < *(uint64_t *)context) ? 100.0F : 400.0F;
+  return in;
+}
+
+static void scenarioAutoRange(void) {
+  printf("getEvent() auto-ranging with 400 dps on X\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro(3);
+  sensors_event_t event;
+  sensor_t sensor;
+
+  setup(Wire, model);
+  model.setSignal(400.0F, 0, 0);
+  gyro.enableAutoRange(true);
+  gyro.setAutoRangeHysteresis(75, 20);
+  gyro.begin(GYRO_RANGE_250DPS);
+  delay(20);
+  Wire.resetStats();
+  gyro.getEvent(&event);
+  gyro.getSensor(&sensor);
+  check(sensor.max_value > 250 * SENSORS_DPS_TO_RADS, "range escalated");
+  check((Wire.stats.transactions == 3) && (Wire.stats.bytesWritten == 6),
+        "escalation only writes CTRL_REG4");
+  check(near(event.gyro.x, 32767 * 0.00875F * SENSORS_DPS_TO_RADS, 0.001F),
+        "saturated sample returned clipped at its own range");
+  gyro.getEvent(&event);
+  check(near(event.gyro.x, 32767 * 0.00875F * SENSORS_DPS_TO_RADS, 0.001F),
+        "output not refreshed yet is still read at the old range");
+  delayMicroseconds(gyro.getSamplePeriod());
+  gyro.getEvent(&event);
+  check(near(event.gyro.x, 400.0F * SENSORS_DPS_TO_RADS, 0.002F),
+        "next sample reads 6.981 rad/s at 500 dps");
+
+  model.setSignal(100.0F, 0, 0);
+  for (uint8_t i = 0; i < 19; i++) {
+    delayMicroseconds(gyro.getSamplePeriod());
+    gyro.getEvent(&event);
+  }
+  gyro.getSensor(&sensor);
+  check(sensor.max_value > 250 * SENSORS_DPS_TO_RADS,
+        "no step down before the hold time");
+  delayMicroseconds(gyro.getSamplePeriod());
+  gyro.getEvent(&event);
+  gyro.getSensor(&sensor);
+  check(sensor.max_value < 251 * SENSORS_DPS_TO_RADS,
+        "steps down after 20 quiet samples");
+  delayMicroseconds(gyro.getSamplePeriod());
+  gyro.getEvent(&event);
+  check(near(event.gyro.x, 100.0F * SENSORS_DPS_TO_RADS, 0.001F),
+        "reads 1.745 rad/s back at 250 dps");
+
+  /* Step from 100 to 400 dps while the FIFO fills */
+  gyroRawData_t samples[2 * L3GD20_FIFO_SIZE];
+  uint64_t step = 15000000ULL;
+  model.reset();
+  setup(Wire, model);
+  model.setSignal(stepSignal, &step);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin(GYRO_RANGE_250DPS);
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  delay(20);
+  size_t count = gyro.readFifo(samples, 8);
+  bool ok = (count == 8) && (samples[7].x == 11429);
+  count = gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+  delay(10);
+  count += gyro.readFifo(&samples[count], L3GD20_FIFO_SIZE);
+  int16_t last = 0;
+  for (size_t i = 0; i < count; i++) {
+    /* 100 and 400 dps taken at 250 dps, then 400 dps at 500 dps */
+    int16_t x = samples[i].x;
+    ok = ok && ((x == 11429 / 2) || (x == 32767 / 2) || (x == 22857)) &&
+         (x >= last);
+    last = x;
+  }
+  check(ok && (last == 22857), "FIFO samples rescaled across the change");
+
+  /* Same step, with samples already waiting in the interrupt buffer */
+  gyroRawData_t ring[64];
+  model.reset();
+  setup(Wire, model);
+  gyro.begin(GYRO_RANGE_250DPS);
+  gyro.attachSampleBuffer(ring, 64);
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  step = SimClock::now() + 10000000ULL;
+  delay(8);
+  gyro.handleInterrupt();
+  delay(10);
+  gyro.handleInterrupt();
+  delay(10);
+  gyro.handleInterrupt();
+  count = gyro.readSamples(samples, 2 * L3GD20_FIFO_SIZE);
+  ok = (count > 0) && (samples[0].x == 11429 / 2);
+  last = 0;
+  for (size_t i = 0; i < count; i++) {
+    int16_t x = samples[i].x;
+    ok = ok && ((x == 11429 / 2) || (x == 32767 / 2) || (x == 22857)) &&
+         (x >= last);
+    last = x;
+  }
+  check(ok && (last == 22857), "buffered samples rescaled across the change");
+
+  /* Same step while a drain wraps around the end of a 32 sample ring */
+  gyroRawData_t small[32];
+  model.reset();
+  setup(Wire, model);
+  model.setSignal(stepSignal, &step);
+  step = ~0ULL;
+  gyro.begin(GYRO_RANGE_250DPS);
+  gyro.attachSampleBuffer(small, 32);
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  delay(26);
+  gyro.handleInterrupt();
+  count = gyro.readSamples(samples, 2 * L3GD20_FIFO_SIZE);
+  /* 13 samples fit before the end of the ring, the step comes after 14 */
+  step = SimClock::now() + 14 * 1316000ULL;
+  delay(25);
+  gyro.handleInterrupt();
+  count = gyro.readSamples(samples, 2 * L3GD20_FIFO_SIZE);
+  ok = (count == 22) && (samples[0].x == 11429 / 2) &&
+       (gyro.getRange() == GYRO_RANGE_500DPS);
+  last = 0;
+  for (size_t i = 0; i < count; i++) {
+    int16_t x = samples[i].x;
+    ok = ok && ((x == 11429 / 2) || (x == 32767 / 2) || (x == 22857)) &&
+         (x >= last);
+    last = x;
+  }
+  check(ok && (last == 32767 / 2), "wrapped drain rescaled across the change");
+
+  /* A quiet stretch right after the wrap must not step down while the
+     louder part before it is still unpublished. The ring now has room
+     for 3 samples before the end. At 95 Hz no sample arrives during the
+     drain, so the FIFO reads empty after it. */
+  model.update();
+  model.setSignal(300.0F, 0, 0);
+  gyro.setDataRate(GYRO_DATARATE_95HZ);
+  delay(172);
+  gyro.handleInterrupt();
+  gyro.readSamples(samples, 2 * L3GD20_FIFO_SIZE);
+  model.update();
+  delay(30);
+  model.update();
+  model.setSignal(100.0F, 0, 0);
+  delay(265);
+  model.update();
+  gyro.handleInterrupt();
+  count = gyro.readSamples(samples, 2 * L3GD20_FIFO_SIZE);
+  ok = (gyro.getRange() == GYRO_RANGE_500DPS);
+  for (size_t i = 0; i < count; i++) {
+    ok = ok && ((samples[i].x == 17143) || (samples[i].x == 5714));
+  }
+  check(ok, "no step down before a wrapped drain is published");
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+
+  /* A quiet stretch ends while the FIFO still holds louder samples */
+  model.reset();
+  setup(Wire, model);
+  model.setSignal(400.0F, 0, 0);
+  gyro.begin(GYRO_RANGE_250DPS);
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  delay(10);
+  gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+  delay(10);
+  gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+  model.update();
+  model.setSignal(100.0F, 0, 0);
+  gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+  delay(30);
+  model.update();
+  model.setSignal(300.0F, 0, 0);
+  delay(6);
+  model.update();
+  count = gyro.readFifo(samples, 22);
+  ok = (count == 22) && (samples[21].x == 5714);
+  count = gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+  ok = ok && (count > 0) && (samples[count - 1].x == 17143);
+  gyro.getSensor(&sensor);
+  check(ok && (sensor.max_value > 250 * SENSORS_DPS_TO_RADS),
+        "no step down while wider samples wait in the FIFO");
+}
+
+static void scenarioFifo(void) {
+  printf("readFifo() at 760 Hz\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro(4);
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+
+  setup(Wire, model);
+  model.setSignal(10.0F, 20.0F, 30.0F);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  delay(20);
+  uint8_t level = model.fifoLevel();
+  Wire.resetStats();
+  size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+  check((level >= 14) && (count == level), "drained every queued sample");
+  check(model.fifoLevel() <= 2, "only samples taken during the drain left");
+  check((samples[0].x == 1143) && (samples[count - 1].z == 3429),
+        "sample values intact");
+  printf("  %u samples in %u transactions, %u bytes\n", (unsigned)count,
+         (unsigned)Wire.stats.transactions,
+         (unsigned)(Wire.stats.bytesWritten + Wire.stats.bytesRead));
+}
+
+static void scenarioBusErrors(void) {
+  printf("bounded reads on a failing bus\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro(5);
+  sensors_event_t event;
+
+  setup(Wire, model);
+  model.setSignal(0, 0, 50.0F);
+  gyro.begin();
+  delay(20);
+
+  Wire.nackNext(1000);
+  check(!gyro.getEvent(&event), "getEvent() gives up on a dead bus");
+  Wire.nackNext(0);
+
+  Wire.nackNext(2);
+  gyro.startRead();
+  uint8_t polls = 0;
+  while (gyro.pollRead() == GYRO_READ_BUSY) {
+    polls++;
+  }
+  check(gyro.completeRead(&event) &&
+            near(event.gyro.z, 50.0F * SENSORS_DPS_TO_RADS, 0.001F),
+        "async read recovers from two NACKs");
+  printf("  completed after %u polls\n", (unsigned)polls + 1);
+
+  Wire.nackNext(100);
+  gyro.setReadLimits(3, 10);
+  gyro.startRead();
+  while (gyro.pollRead() == GYRO_READ_BUSY) {
+  }
+  check(gyro.pollRead() == GYRO_READ_ERROR, "async read stops after retries");
+  check(!gyro.completeRead(&event) && (gyro.pollRead() == GYRO_READ_IDLE),
+        "reader returns to idle");
+  Wire.nackNext(0);
+}
+
+/* Largest timestamp error of a batch whose newest sample is 'newest' */
+static int32_t stampError(L3GD20Model &model, const uint32_t *timestamps,
+                          size_t count, uint32_t newest) {
+  int32_t worst = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t index = newest - (count - 1 - i);
+    uint64_t taken = model.sampleTimeNs(index);
+    int32_t error = (int32_t)(timestamps[i] - (uint32_t)(taken / 1000));
+    if (abs(error) > abs(worst)) {
+      worst = error;
+    }
+  }
+  return worst;
+}
+
+static void scenarioGroup(void) {
+  printf("three sensors on two buses read as a group\n");
+  L3GD20Model a, b, c;
+  Adafruit_L3GD20_Unified gyroA(6), gyroB(7), gyroC(8);
+  Adafruit_L3GD20_Unified *gyros[] = {&gyroA, &gyroB, &gyroC};
+  Adafruit_L3GD20_Group group(gyros, 3);
+  gyroRawData_t samples[3];
+  uint32_t timestamp;
+
+  setup(Wire, a);
+  Wire.attach(L3GD20_ADDRESS_ALT, &b);
+  Wire1 = TwoWire();
+  Wire1.attach(L3GD20_ADDRESS, &c);
+  a.setSignal(10.0F, 0, 0);
+  b.setSignal(0, 20.0F, 0);
+  c.setSignal(0, 0, 30.0F);
+
+  check(gyroA.begin(GYRO_RANGE_250DPS, &Wire, L3GD20_ADDRESS) &&
+            gyroB.begin(GYRO_RANGE_500DPS, &Wire, L3GD20_ADDRESS_ALT) &&
+            gyroC.begin(GYRO_RANGE_2000DPS, &Wire1, L3GD20_ADDRESS),
+        "all three detected");
+  check((a.peek(0x23) == 0x00) && (b.peek(0x23) == 0x10) &&
+            (c.peek(0x23) == 0x20),
+        "each sensor got its own range");
+  delay(20);
+  check(group.read(samples, &timestamp) == 0x07, "one pass reads all three");
+  check((samples[0].x == 1143) && (samples[1].y == 1143) &&
+            (samples[2].z == 429),
+        "samples come from the right sensors");
+  L3GD20Model *models[] = {&a, &b, &c};
+  bool stamped = true;
+  for (uint8_t i = 0; i < 3; i++) {
+    L3GD20Model &m = *models[i];
+    int32_t error = stampError(m, &gyros[i]->timestamp, 1,
+                               m.samplesGenerated - 1);
+    stamped = stamped && (abs(error) < 100) &&
+              (memcmp(&gyros[i]->raw, &samples[i], sizeof(samples[i])) == 0);
+  }
+  check(stamped, "each sensor's raw and timestamp updated");
+
+  a.setSignal(400.0F, 0, 0);
+  gyroA.enableAutoRange(true);
+  delay(11);
+  group.read(samples);
+  check(gyroA.getRange() == GYRO_RANGE_500DPS, "group read auto-ranges");
+  gyroB.enableFifo(GYRO_FIFO_STREAM);
+  delay(11);
+  check(group.read(samples) == 0x05, "sensor with the FIFO on is skipped");
+  gyroB.enableFifo(GYRO_FIFO_BYPASS);
+  Wire1 = TwoWire();
+  check(group.read(samples) == 0x03, "a missing sensor is reported");
+}
+
+static void scenarioSpi(void) {
+  printf("hardware SPI transport\n");
+  L3GD20Model model(SIM_L3GD20H);
+  Adafruit_L3GD20_Unified gyro(10, &SPI, 9);
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  sensors_event_t event;
+
+  SimClock::reset();
+  SPI = SPIClass();
+  SPI.attach(10, &model);
+  model.setSignal(0, 0, -75.0F);
+  check(gyro.begin(GYRO_RANGE_500DPS), "detected over SPI");
+  check(model.peek(0x23) == 0x10, "range written over SPI");
+  delay(20);
+  gyro.getEvent(&event);
+  check(near(event.gyro.z, -75.0F * SENSORS_DPS_TO_RADS, 0.001F),
+        "Z reads -1.309 rad/s");
+
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  delay(30);
+  uint8_t level = model.fifoLevel();
+  SPI.resetStats();
+  size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+  check((count == level) && (samples[count - 1].z == -4286),
+        "FIFO drained");
+  check(SPI.stats.transactions == 2, "FIFO level and data in two frames");
+}
+
+static void scenarioShadow(void) {
+  printf("configuration through the register shadow\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro(11);
+
+  setup(Wire, model);
+  gyro.begin(GYRO_RANGE_500DPS);
+  Wire.resetStats();
+  gyro.setDataRate(GYRO_DATARATE_760HZ, GYRO_BANDWIDTH_3);
+  gyro.enableInterrupts(true);
+  check((Wire.stats.transactions == 2) && (Wire.stats.bytesRead == 0),
+        "read-modify-writes need no reads");
+  check((model.peek(0x20) == 0xFF) && (model.peek(0x22) == 0x08) &&
+            (model.peek(0x23) == 0x10),
+        "registers hold the new settings");
+
+  Wire.resetStats();
+  gyro.setDataRate(GYRO_DATARATE_760HZ, GYRO_BANDWIDTH_3);
+  check(Wire.stats.transactions == 0, "unchanged settings are not written");
+
+  Wire.nackNext(1);
+  gyro.setDataRate(GYRO_DATARATE_380HZ, GYRO_BANDWIDTH_3);
+  check((model.peek(0x20) >> 6) == 3, "NACKed write leaves the sensor alone");
+  Wire.resetStats();
+  gyro.enableInterrupts(false);
+  check((Wire.stats.transactions == 1) && ((model.peek(0x20) >> 6) == 2) &&
+            (model.peek(0x22) == 0x00),
+        "failed write retried in the next coalesced write");
+}
+
+static void scenarioTransports(void) {
+  printf("compile-time transports\n");
+  L3GD20Model model;
+  gyroRawData_t sample;
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+
+  setup(Wire1, model);
+  model.setSignal(0, 50.0F, 0);
+  Adafruit_L3GD20_Core<Adafruit_L3GD20_I2C> i2c(
+      Adafruit_L3GD20_I2C(&Wire1, L3GD20_ADDRESS));
+  check(i2c.begin(GYRO_RANGE_500DPS), "I2C core detected on Wire1");
+  delay(20);
+  check(i2c.read(&sample) && (sample.y == 2857), "I2C core reads Y");
+
+  L3GD20Model soft(SIM_L3GD20H);
+  SimSoftSPI pins;
+  SimClock::reset();
+  pins.attach(4, 5, 6, 7, &soft);
+  soft.setSignal(0, 0, 100.0F);
+  Adafruit_L3GD20_Core<Adafruit_L3GD20_SoftSPI> bitbang(
+      Adafruit_L3GD20_SoftSPI(4, 5, 6, 7));
+  check(bitbang.begin(GYRO_RANGE_2000DPS, GYRO_DATARATE_760HZ),
+        "bit-bang core detected");
+  check(soft.peek(0x23) == 0x20, "range written bit by bit");
+  delay(10);
+  check(bitbang.read(&sample) && (sample.z == 1429), "bit-bang core reads Z");
+  bitbang.enableFifo(GYRO_FIFO_STREAM);
+  delay(20);
+  uint8_t level = soft.fifoLevel();
+  uint32_t frames = pins.frames;
+  size_t count = bitbang.readFifo(samples, L3GD20_FIFO_SIZE);
+  check((count == level) && (samples[count - 1].z == 1429) &&
+            (pins.frames - frames == 2),
+        "bit-bang FIFO drain in one frame");
+  pins.detach();
+
+  L3GD20Model direct;
+  L3GD20MockBus mock(&direct);
+  SimClock::reset();
+  direct.setSignal(-20.0F, 0, 0);
+  Adafruit_L3GD20_Core<L3GD20MockBus> core(mock);
+  check(core.begin(), "mock core detected");
+  check(core.bus.writes == 3, "begin() writes three registers");
+  delay(20);
+  check(core.read(&sample) && (sample.x == -2286) &&
+            near(sample.x * core.getScale(), -20.0F * SENSORS_DPS_TO_RADS,
+                 0.001F),
+        "mock core reads X");
+
+  /* Everything known at compile time */
+  typedef Adafruit_L3GD20_Fixed<L3GD20MockBus, GYRO_RANGE_500DPS,
+                                GYRO_VARIANT_L3GD20H, GYRO_DATARATE_12_5HZ,
+                                GYRO_BANDWIDTH_1>
+      fixedGyro_t;
+  static_assert(fixedGyro_t::getScale() == GYRO_SCALE_500DPS,
+                "scale folded at compile time");
+  static_assert(fixedGyro_t::getSamplePeriod() == 80000,
+                "period folded at compile time");
+  L3GD20Model h(SIM_L3GD20H);
+  L3GD20MockBus fixedBus(&h);
+  SimClock::reset();
+  h.setSignal(0, 0, 300.0F);
+  fixedGyro_t fixed(fixedBus, 7);
+  sensors_event_t event;
+  sensor_t sensor;
+  check(fixed.begin() && (fixed.bus.writes == 4), "fixed begin() on the H");
+  check((h.peek(GYRO_REGISTER_CTRL_REG1) == 0x1F) &&
+            (h.peek(GYRO_REGISTER_LOW_ODR) == 0x01) &&
+            (h.peek(GYRO_REGISTER_CTRL_REG4) == 0x10),
+        "compile-time CTRL values written");
+  delay(100);
+  check(fixed.getEvent(&event) && (event.sensor_id == 7) &&
+            near(event.gyro.z, 300.0F * SENSORS_DPS_TO_RADS, 0.002F),
+        "fixed getEvent() reads 5.236 rad/s");
+  fixed.getSensor(&sensor);
+  check((strcmp(sensor.name, "L3GD20H") == 0) &&
+            (sensor.min_delay == 80000) &&
+            near(sensor.max_value, 500 * SENSORS_DPS_TO_RADS, 0.001F),
+        "fixed sensor description");
+  Adafruit_L3GD20_Fixed<L3GD20MockBus> wrongChip(fixedBus);
+  check(!wrongChip.begin(), "fixed begin() rejects the other chip");
+}
+
+/* Waits for DRDY/INT2 like a pin interrupt would, then records it */
+static void waitInterrupt(L3GD20Model &model, Adafruit_L3GD20_Unified &gyro) {
+  while (!model.int2()) {
+    delayMicroseconds(20);
+  }
+  gyro.markInterrupt();
+}
+
+static void scenarioTimestamps(void) {
+  printf("sample timestamps with a 0.2%% slow sensor clock\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  uint32_t stamps[L3GD20_FIFO_SIZE];
+  int32_t worst = 0;
+
+  setup(Wire, model);
+  model.setRateError(2000);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  for (uint32_t i = 0; i < 400; i++) {
+    /* Polled at an uneven pace, no interrupt */
+    delayMicroseconds(20000 + (i * 3779) % 5000);
+    size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE, stamps);
+    uint32_t newest = model.fifoLevel();
+    newest = model.samplesGenerated - 1 - newest;
+    int32_t error = stampError(model, stamps, count, newest);
+    if ((i >= 200) && (abs(error) > abs(worst))) {
+      worst = error;
+    }
+  }
+  printf("  polled FIFO: period %u ns, worst error %d us\n",
+         (unsigned)gyro.getMeasuredPeriod(), (int)worst);
+  check(abs((int32_t)gyro.getMeasuredPeriod() - 1318632) < 1000,
+        "polled FIFO tracks the slow clock");
+  check(abs(worst) < 100, "polled FIFO stamps within 100 us");
+
+  gyroRawData_t ring[64];
+  uint32_t ringStamps[64];
+  setup(Wire, model);
+  model.reset();
+  gyro.begin();
+  gyro.attachSampleBuffer(ring, 64, ringStamps);
+  gyro.enableFifo(GYRO_FIFO_STREAM, 16);
+  gyro.enableInterrupts(false, true);
+  worst = 0;
+  for (uint32_t i = 0; i < 200; i++) {
+    waitInterrupt(model, gyro);
+    gyro.handleInterrupt();
+    size_t count = gyro.readSamples(samples, L3GD20_FIFO_SIZE, stamps);
+    uint32_t newest = model.fifoLevel();
+    newest = model.samplesGenerated - 1 - newest;
+    int32_t error = stampError(model, stamps, count, newest);
+    if ((i >= 100) && (abs(error) > abs(worst))) {
+      worst = error;
+    }
+  }
+  printf("  watermark interrupt: period %u ns, worst error %d us\n",
+         (unsigned)gyro.getMeasuredPeriod(), (int)worst);
+  check(abs(worst) <= 25, "watermark stamps within the interrupt latency");
+
+  sensors_event_t event;
+  setup(Wire, model);
+  model.reset();
+  gyro.begin();
+  gyro.enableFifo(GYRO_FIFO_BYPASS);
+  gyro.enableInterrupts(true, false);
+  worst = 0;
+  for (uint32_t i = 0; i < 400; i++) {
+    waitInterrupt(model, gyro);
+    gyro.getEvent(&event);
+    uint64_t taken = model.sampleTimeNs(model.samplesGenerated - 1);
+    int32_t error = (int32_t)(gyro.timestamp - (uint32_t)(taken / 1000));
+    if ((i >= 200) && (abs(error) > abs(worst))) {
+      worst = error;
+    }
+  }
+  printf("  data-ready interrupt: worst error %d us\n", (int)worst);
+  check(abs(worst) <= 25, "data-ready stamps within the interrupt latency");
+  check(abs((int32_t)(event.timestamp - gyro.timestamp / 1000)) <= 1,
+        "event timestamp is the sample time");
+}
+
+static void scenarioStatusRead(void) {
+  printf("temperature, status and sample in one read\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+
+  setup(Wire, model);
+  model.setSignal(0, 0, 40.0F, 37);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  gyro.enableStatusRead(true);
+  delayMicroseconds(1500);
+  Wire.resetStats();
+  check(gyro.getEvent(&event) && (gyro.raw.z == 4571) &&
+            (gyro.temperature == 37),
+        "sample and temperature read");
+  check((Wire.stats.transactions == 2) && (Wire.stats.bytesRead == 8),
+        "one 8 byte burst");
+  check(!gyro.getEvent(&event) && (gyro.raw.z == 4571),
+        "no new sample is not returned twice");
+  check(gyro.overruns == 0, "no overrun yet");
+  delayMicroseconds(3 * 1316);
+  check(gyro.getEvent(&event) && (gyro.overruns == 1),
+        "overwritten sample counted");
+
+  gyroReadStatus_t status;
+  delayMicroseconds(1316);
+  gyro.startRead();
+  while ((status = gyro.pollRead()) == GYRO_READ_BUSY) {
+  }
+  check((status == GYRO_READ_DONE) && gyro.completeRead(&event),
+        "async status read");
+  gyro.startRead();
+  while ((status = gyro.pollRead()) == GYRO_READ_BUSY) {
+  }
+  check((status == GYRO_READ_STALE) && !gyro.completeRead(&event),
+        "async read reports no new sample");
+}
+
+/* Constant rate plus uniform noise, at a given temperature */
+typedef struct {
+  float x, y, z;
+  float noise;
+  int8_t temperature;
+  uint32_t seed;
+} noisySignal_t;
+
+static simSignal_t noisySignal(uint64_t t_ns, void *context) {
+  noisySignal_t *in = (noisySignal_t *)context;
+  simSignal_t out;
+  float n[3];
+  (void)t_ns;
+  for (uint8_t i = 0; i < 3; i++) {
+    in->seed = in->seed * 1664525 + 1013904223;
+    n[i] = ((in->seed >> 8) / 16777216.0F * 2 - 1) * in->noise;
+  }
+  out.x = in->x + n[0];
+  out.y = in->y + n[1];
+  out.z = in->z + n[2];
+  out.temperature = in->temperature;
+  return out;
+}
+
+/* Reads 'count' samples through the FIFO, converted with the bias applied */
+static void readConverted(Adafruit_L3GD20_Unified &gyro, size_t count,
+                          float *mean) {
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  float out[3 * L3GD20_FIFO_SIZE];
+  size_t done = 0;
+  mean[0] = mean[1] = mean[2] = 0;
+  while (done < count) {
+    delay(20);
+    size_t n = gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+    gyro.convertSamples(samples, out, n);
+    for (size_t i = 0; i < n; i++) {
+      for (uint8_t axis = 0; axis < 3; axis++) {
+        mean[axis] += out[3 * i + axis] / SENSORS_DPS_TO_RADS;
+      }
+    }
+    done += n;
+  }
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    mean[axis] /= done;
+  }
+}
+
+static void scenarioBias(void) {
+  printf("zero-rate bias learned while still\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+  gyroFixedData_t fixed;
+  gyroBiasTable_t table;
+  noisySignal_t in = {0.5F, -0.3F, 1.2F, 0.3F, 20, 1};
+  float mean[3];
+
+  setup(Wire, model);
+  model.setSignal(noisySignal, &in);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  gyro.enableStatusRead(true);
+  gyro.enableBiasCompensation(true);
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+
+  readConverted(gyro, 400, mean);
+  gyro.getBiasTable(&table);
+  check(table.valid == 0x10, "estimate stored in the middle bin");
+  readConverted(gyro, 400, mean);
+  printf("  residual %.4f %.4f %.4f dps\n", mean[0], mean[1], mean[2]);
+  check(fabsf(mean[0]) < 0.02F && fabsf(mean[1]) < 0.02F &&
+            fabsf(mean[2]) < 0.02F,
+        "batch conversion compensated");
+
+  in.noise = 0;
+  gyro.enableFifo(GYRO_FIFO_BYPASS);
+  delay(2);
+  check(gyro.getEvent(&event) && near(event.gyro.z, 0, 0.0005F),
+        "getEvent() compensated");
+  delay(2);
+  check(gyro.getEventFixed(&fixed) && (abs(fixed.z) <= 30),
+        "getEventFixed() compensated");
+
+  /* 16 LSB warmer is two bins up, with a different X bias */
+  in.temperature = 36;
+  in.x = 1.0F;
+  in.noise = 0.3F;
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  /* A step this small doesn't end a still period, start a new one */
+  gyro.enableBiasCompensation(true);
+  delay(L3GD20_TEMP_INTERVAL_MS);
+  readConverted(gyro, 400, mean);
+  gyro.getBiasTable(&table);
+  check(table.valid == 0x50, "second temperature in its own bin");
+  in.temperature = 28;
+  in.x = 0.75F;
+  gyro.enableBiasCompensation(true, false);
+  delay(L3GD20_TEMP_INTERVAL_MS);
+  readConverted(gyro, 200, mean);
+  check(fabsf(mean[0]) < 0.03F, "bias interpolated between bins");
+
+  gyro.enableBiasCompensation(true);
+  in.x = 100.0F;
+  readConverted(gyro, 400, mean);
+  gyroBiasTable_t after;
+  gyro.getBiasTable(&after);
+  check(memcmp(&table, &after, sizeof(table)) == 0,
+        "nothing learned while turning");
+
+  Adafruit_L3GD20_Unified restored;
+  model.reset();
+  restored.setDataRate(GYRO_DATARATE_760HZ);
+  restored.begin();
+  restored.enableStatusRead(true);
+  restored.setBiasTable(&table);
+  restored.enableBiasCompensation(true, false);
+  in.x = 1.0F;
+  in.temperature = 36;
+  in.noise = 0;
+  delay(2);
+  check(restored.getEvent(&event) && near(event.gyro.x, 0, 0.0005F),
+        "restored table applies at once");
+}
+
+static void scenarioAttitude(void) {
+  printf("attitude integrated over FIFO batches\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  Adafruit_L3GD20_Attitude attitude;
+  Adafruit_L3GD20_AttitudeFixed fixed;
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  uint32_t stamps[L3GD20_FIFO_SIZE];
+  uint32_t first = 0, last = 0;
+
+  /* 87.5 dps is exactly 10000 LSB at 250 dps */
+  setup(Wire, model);
+  model.setRateError(-1500);
+  model.setSignal(0, 0, 87.5F);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  for (uint32_t i = 0; i < 100; i++) {
+    delay(20);
+    size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE, stamps);
+    if (count == 0) {
+      continue;
+    }
+    if (i == 0) {
+      first = stamps[0];
+    }
+    last = stamps[count - 1];
+    attitude.update(samples, stamps, count, gyro.getScale());
+    fixed.update(samples, stamps, count, gyro.getRange());
+  }
+
+  float q[4];
+  int32_t qf[4];
+  attitude.getQuaternion(q);
+  fixed.getQuaternion(qf);
+  double half = 87.5 * M_PI / 180.0 * (last - first) * 1e-6 / 2;
+  float expect[4] = {(float)cos(half), 0, 0, (float)sin(half)};
+  float worst = 0, worstFixed = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    worst = fmaxf(worst, fabsf(q[i] - expect[i]));
+    worstFixed = fmaxf(worstFixed, fabsf(qf[i] / 1073741824.0F - expect[i]));
+  }
+  printf("  %.1f deg: float %.6f %.6f, fixed %.6f %.6f\n",
+         half * 360.0 / M_PI, q[0], q[3], qf[0] / 1073741824.0F,
+         qf[3] / 1073741824.0F);
+  check(worst < 1e-4F, "float quaternion follows the rotation");
+  check(worstFixed < 1e-4F, "fixed quaternion follows the rotation");
+  float norm = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+  check(fabsf(norm - 1.0F) < 1e-5F, "quaternion stays normalised");
+
+  /* 1750 dps at 95 Hz turns 18.4 degrees per sample */
+  attitude.reset();
+  fixed.reset();
+  for (uint8_t i = 0; i < L3GD20_FIFO_SIZE; i++) {
+    samples[i].x = 0;
+    samples[i].y = 0;
+    samples[i].z = 25000;
+    stamps[i] = i * 10526;
+  }
+  attitude.update(samples, stamps, L3GD20_FIFO_SIZE, GYRO_SCALE_2000DPS);
+  fixed.update(samples, stamps, L3GD20_FIFO_SIZE, GYRO_RANGE_2000DPS);
+  attitude.getQuaternion(q);
+  fixed.getQuaternion(qf);
+  worst = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    worst = fmaxf(worst, fabsf(qf[i] / 1073741824.0F - q[i]));
+  }
+  printf("  fast turn: float %.6f %.6f, fixed %.6f %.6f\n", q[0], q[3],
+         qf[0] / 1073741824.0F, qf[3] / 1073741824.0F);
+  check(worst < 1e-4F, "fixed matches float at high rates");
+}
+
+static void scenarioHighPass(void) {
+  printf("hardware high-pass filter\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+
+  setup(Wire, model);
+  model.setSignal(10.0F, 0, -5.0F);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.setHighPass(GYRO_HIGHPASS_NORMAL, GYRO_HIGHPASS_CUTOFF_3);
+  gyro.begin();
+  check(model.peek(GYRO_REGISTER_CTRL_REG2) == 0x23,
+        "mode and cutoff applied by begin()");
+  delay(2);
+  check(gyro.getEvent(&event) && near(event.gyro.x, 10 * SENSORS_DPS_TO_RADS,
+                                      0.001F),
+        "filter off the path by default");
+
+  /* 7.2 Hz at 760 Hz decays within a few tens of ms */
+  gyro.setFilterPath(GYRO_FILTER_HPF);
+  check((model.peek(GYRO_REGISTER_CTRL_REG5) & 0x13) == 0x11,
+        "HPen and OUT_SEL set");
+  delay(2);
+  gyro.getEvent(&event);
+  float first = event.gyro.x;
+  delay(200);
+  gyro.getEvent(&event);
+  printf("  x %.4f then %.4f rad/s\n", first, event.gyro.x);
+  check(first > 5 * SENSORS_DPS_TO_RADS, "step passes the filter");
+  check(near(event.gyro.x, 0, 0.001F) && near(event.gyro.z, 0, 0.001F),
+        "constant rate removed by the sensor");
+
+  gyro.setHighPass(GYRO_HIGHPASS_NORMAL_RESET, GYRO_HIGHPASS_CUTOFF_9);
+  model.setSignal(30.0F, 0, -5.0F);
+  delay(20);
+  gyro.getEvent(&event);
+  check(event.gyro.x > 15 * SENSORS_DPS_TO_RADS,
+        "low cutoff keeps the new step");
+  gyro.resetHighPass();
+  delay(2);
+  check(gyro.getEvent(&event) && near(event.gyro.x, 0, 0.001F),
+        "resetHighPass() settles the filter");
+
+  gyro.setFilterPath(GYRO_FILTER_LPF1);
+  delay(2);
+  check(gyro.getEvent(&event) &&
+            near(event.gyro.x, 30 * SENSORS_DPS_TO_RADS, 0.001F),
+        "filter taken off the path");
+  gyro.setReference(0x5A);
+  check(model.peek(GYRO_REGISTER_REFERENCE) == 0x5A, "reference written");
+}
+
+static void scenarioMotion(void) {
+  printf("wake on motion through INT1\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+  gyroFixedData_t thresholds = {10000, 10000, 10000};
+
+  setup(Wire, model);
+  model.setSignal(0.5F, -0.4F, 0.2F);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  gyro.enableMotionInterrupt(GYRO_MOTION_ANY_HIGH, &thresholds, 5);
+  check((model.peek(GYRO_REGISTER_TSH_ZH) << 8 |
+         model.peek(GYRO_REGISTER_TSH_ZL)) == 1143,
+        "10 dps threshold in LSB at 250 dps");
+
+  /* The MCU sleeps: no bus traffic until the pin rises */
+  uint32_t transactions = Wire.stats.transactions;
+  bool woke = false;
+  for (uint32_t i = 0; i < 100 && !woke; i++) {
+    delay(10);
+    woke = model.int1();
+  }
+  check(!woke, "no wake-up while still");
+  model.setSignal(0.5F, -0.4F, 30.0F);
+  delay(3);
+  model.setSignal(0.5F, -0.4F, 0.2F);
+  delay(10);
+  check(!model.int1(), "short bump filtered by the duration");
+  model.setSignal(0.5F, -0.4F, 30.0F);
+  delay(20);
+  check(model.int1(), "sustained rotation raises INT1");
+  check(Wire.stats.transactions == transactions, "bus idle while asleep");
+  check(model.int1(), "INT1 latched");
+  check(gyro.handleMotionInterrupt() == GYRO_MOTION_Z_HIGH,
+        "source names the axis");
+  model.setSignal(0.5F, -0.4F, 0.2F);
+  delay(2);
+  gyro.handleMotionInterrupt();
+  check(!model.int1(), "reading the source releases INT1");
+
+  /* Thresholds stay at 10 dps across an auto-range step */
+  gyro.enableAutoRange(true);
+  model.setSignal(400.0F, 0, 0);
+  for (uint8_t i = 0; i < 3; i++) {
+    delay(2);
+    gyro.getEvent(&event);
+  }
+  check((model.peek(GYRO_REGISTER_TSH_ZH) << 8 |
+         model.peek(GYRO_REGISTER_TSH_ZL)) == 571,
+        "threshold rescaled with the range");
+
+  gyro.disableMotionInterrupt();
+  check(!(model.peek(GYRO_REGISTER_CTRL_REG3) & 0x80) && !model.int1(),
+        "disarmed");
+}
+
+/* 300 dps sine on X, 100 dps cosine on Y at 2 Hz, 20 dps on Z */
+static simSignal_t swingSignal(uint64_t t_ns, void *context) {
+  simSignal_t in = {0, 0, 20.0F, 25};
+  float phase = 2 * (float)M_PI * 2.0F * t_ns * 1e-9F;
+  (void)context;
+  in.x = 300.0F * sinf(phase);
+  in.y = 100.0F * cosf(phase);
+  return in;
+}
+
+static void scenarioStream(void) {
+  printf("binary stream round trip\n");
+  static uint8_t log[40 * L3GD20_STREAM_MAX_FRAME];
+  static gyroRawData_t sent[40][L3GD20_FIFO_SIZE];
+  static uint32_t sentStamps[40][L3GD20_FIFO_SIZE];
+  size_t sentCount[40];
+  gyroRange_t sentRange[40];
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  size_t used = 0, samples = 0, broken = 0;
+
+  setup(Wire, model);
+  model.setSignal(swingSignal);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.enableAutoRange(true);
+  gyro.begin();
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  for (uint8_t f = 0; f < 40; f++) {
+    delay(25);
+    sentCount[f] = gyro.readFifo(sent[f], L3GD20_FIFO_SIZE, sentStamps[f]);
+    sentRange[f] = gyro.getRange();
+    samples += sentCount[f];
+    if (f == 10) {
+      broken = used + L3GD20_STREAM_HEADER + 7;
+    }
+    if (f == 20) {
+      /* Line noise between frames, with a false sync byte */
+      memcpy(log + used, "\x00\xA5\x13\x37", 4);
+      used += 4;
+    }
+    used += l3gd20EncodeFrame(log + used, sizeof(log) - used, sent[f],
+                              sentStamps[f], sentCount[f], sentRange[f]);
+  }
+  size_t bytes = used - 4;
+  log[broken] ^= 0x10;
+
+  Adafruit_L3GD20_StreamDecoder decoder;
+  uint8_t f = 0;
+  bool same = true, timely = true;
+  for (size_t i = 0; i < used; i++) {
+    if (!decoder.feed(log[i])) {
+      continue;
+    }
+    if (f == 10) {
+      f++; // lost to the flipped bit
+    }
+    same = same && (f < 40) && (decoder.count == sentCount[f]) &&
+           (decoder.range == sentRange[f]) &&
+           !memcmp(decoder.samples, sent[f], decoder.count * 6);
+    for (uint8_t n = 0; same && (n < decoder.count); n++) {
+      timely = timely && (abs((int32_t)(decoder.timestamps[n] -
+                                        sentStamps[f][n])) <= 1);
+    }
+    f++;
+  }
+  printf("  %u samples in %u bytes, %.2f bytes per sample, %u errors\n",
+         (unsigned)samples, (unsigned)bytes, (double)bytes / samples,
+         (unsigned)decoder.errors);
+  check(sentRange[39] == GYRO_RANGE_500DPS, "frames at both ranges");
+  check(f == 40, "every other frame decoded");
+  check(same, "samples and ranges identical");
+  check(timely, "timestamps within 1 us");
+  check(decoder.errors >= 2, "corruption and line noise counted");
+  /* Raw samples alone are 6 bytes, 10 with a timestamp */
+  check(bytes < samples * 6, "under 6 bytes per stamped sample");
+
+  float rates[3 * L3GD20_STREAM_MAX_SAMPLES];
+  decoder.convertSamples(rates);
+  check(near(rates[2], 20 * SENSORS_DPS_TO_RADS, 0.001F),
+        "decoded to rad/s");
+}
+
+static void scenarioConvert(void) {
+  printf("batch conversions against getEvent()\n");
+  const gyroRange_t ranges[] = {GYRO_RANGE_250DPS, GYRO_RANGE_500DPS,
+                                GYRO_RANGE_2000DPS};
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  float expected[3 * L3GD20_FIFO_SIZE];
+  float aos[3 * L3GD20_FIFO_SIZE];
+  float x[L3GD20_FIFO_SIZE], y[L3GD20_FIFO_SIZE], z[L3GD20_FIFO_SIZE];
+  gyroFixedData_t fixed[L3GD20_FIFO_SIZE];
+
+  for (uint8_t r = 0; r < 3; r++) {
+    setup(Wire, model);
+    model.reset();
+    model.setSignal(swingSignal, NULL);
+    gyro.begin(ranges[r]);
+    delay(20);
+    for (uint8_t i = 0; i < L3GD20_FIFO_SIZE; i++) {
+      gyro.getEvent(&event);
+      samples[i] = gyro.raw;
+      expected[3 * i] = event.gyro.x;
+      expected[3 * i + 1] = event.gyro.y;
+      expected[3 * i + 2] = event.gyro.z;
+      delay(7);
+    }
+    gyro.convertSamples(samples, aos, L3GD20_FIFO_SIZE);
+    gyro.convertSamples(samples, x, y, z, L3GD20_FIFO_SIZE);
+    gyro.convertSamplesFixed(samples, fixed, L3GD20_FIFO_SIZE);
+    bool same = true;
+    bool close = true;
+    for (uint8_t i = 0; i < L3GD20_FIFO_SIZE; i++) {
+      const float *e = &expected[3 * i];
+      same = same && (aos[3 * i] == e[0]) && (aos[3 * i + 1] == e[1]) &&
+             (aos[3 * i + 2] == e[2]) && (x[i] == e[0]) && (y[i] == e[1]) &&
+             (z[i] == e[2]);
+      const int32_t mdps[3] = {fixed[i].x, fixed[i].y, fixed[i].z};
+      for (uint8_t a = 0; a < 3; a++) {
+        close = close && near(mdps[a] / 1000.0F, e[a] / SENSORS_DPS_TO_RADS,
+                              0.001F);
+      }
+    }
+    printf("  %d dps: x %.4f..%.4f rad/s\n", (int)ranges[r], expected[0],
+           expected[3 * (L3GD20_FIFO_SIZE - 1)]);
+    check(same, "AoS and SoA match getEvent()");
+    check(close, "fixed point within 1 mdps of getEvent()");
+  }
+}
+
+static void scenarioAxes(void) {
+  printf("yaw only\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+  gyroFixedData_t fixed;
+
+  setup(Wire, model);
+  model.setSignal(10.0F, -20.0F, 30.0F);
+  gyro.setAxes(GYRO_AXIS_Z);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+  check((model.peek(GYRO_REGISTER_CTRL_REG1) & 0x0F) == 0x0C,
+        "only ZEN set by begin()");
+
+  delay(2);
+  uint32_t bytes = Wire.stats.bytesRead;
+  check(gyro.getEvent(&event), "getEvent()");
+  printf("  %u data bytes per read\n",
+         (unsigned)(Wire.stats.bytesRead - bytes));
+  check(Wire.stats.bytesRead - bytes == 2, "only OUT_Z read");
+  check((event.gyro.x == 0) && (event.gyro.y == 0) &&
+            near(event.gyro.z, 30 * SENSORS_DPS_TO_RADS, 0.001F),
+        "X and Y read as 0");
+  delay(2);
+  check(gyro.getEventFixed(&fixed) && (fixed.x == 0) && (fixed.y == 0) &&
+            (abs(fixed.z - 30000) < 10),
+        "getEventFixed() too");
+
+  gyro.setAxes(GYRO_AXIS_X | GYRO_AXIS_Y);
+  check((model.peek(GYRO_REGISTER_CTRL_REG1) & 0x07) == 0x03,
+        "axes changed on the fly");
+  delay(2);
+  bytes = Wire.stats.bytesRead;
+  gyro.getEvent(&event);
+  check((Wire.stats.bytesRead - bytes == 4) && (event.gyro.z == 0) &&
+            near(event.gyro.y, -20 * SENSORS_DPS_TO_RADS, 0.001F),
+        "window OUT_X_L..OUT_Y_H");
+
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  float z[L3GD20_FIFO_SIZE];
+  gyro.setAxes(GYRO_AXIS_Z);
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  delay(20);
+  size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+  bool masked = count > 10;
+  for (size_t i = 0; i < count; i++) {
+    masked = masked && (samples[i].x == 0) && (samples[i].y == 0) &&
+             (samples[i].z != 0);
+  }
+  check(masked, "FIFO samples masked");
+  gyro.convertSamples(samples, NULL, NULL, z, count);
+  check(near(z[count - 1], 30 * SENSORS_DPS_TO_RADS, 0.001F),
+        "SoA conversion of Z alone");
+  delay(2);
+  check(gyro.getEvent(&event) &&
+            near(event.gyro.z, 30 * SENSORS_DPS_TO_RADS, 0.001F),
+        "getEvent() with the FIFO on still moves through it");
+}
+
+/* Average supply current in mA from the datasheet figures: 6.1 mA in
+   normal mode, 2 mA in sleep mode, 5 uA in power-down mode */
+static float averageCurrent(const uint64_t *ns) {
+  float total = (float)(ns[0] + ns[1] + ns[2]);
+  return (6.1F * ns[0] + 2.0F * ns[1] + 0.005F * ns[2]) / total;
+}
+
+static void scenarioPowerModes(void) {
+  printf("sleep, power-down and duty cycling\n");
+  L3GD20Model model;
+  Adafruit_L3GD20_Unified gyro;
+  sensors_event_t event;
+
+  setup(Wire, model);
+  model.setSignal(0, 0, 50.0F);
+  model.setTurnOnTime(4000000, 200000000);
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.begin();
+
+  gyro.setPowerMode(GYRO_POWER_SLEEP);
+  check((model.peek(GYRO_REGISTER_CTRL_REG1) & 0x0F) == 0x08,
+        "sleep: PD set, axes off");
+  uint32_t bytes = Wire.stats.bytesRead;
+  delay(100);
+  check(!gyro.getEvent(&event) && (Wire.stats.bytesRead == bytes),
+        "no reads while asleep");
+
+  /* The first samples after a wake are discarded */
+  gyro.setPowerMode(GYRO_POWER_NORMAL);
+  uint32_t wake = micros();
+  uint32_t turnOn = model.samplesTurnOn;
+  bool got = false;
+  for (uint8_t i = 0; (i < 20) && !got; i++) {
+    delay(1);
+    got = gyro.getEvent(&event);
+  }
+  check(model.samplesTurnOn > turnOn, "turn-on glitch generated");
+  check(got && near(event.gyro.z, 50 * SENSORS_DPS_TO_RADS, 0.001F),
+        "first sample after sleep is valid");
+  check(gyro.timestamp - wake >= L3GD20_SLEEP_WAKE_US,
+        "taken after the sleep wake latency");
+
+  /* From power-down through the FIFO, at 95 Hz so it spans the wake */
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  uint32_t times[L3GD20_FIFO_SIZE];
+  gyro.setDataRate(GYRO_DATARATE_95HZ);
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  gyro.setPowerMode(GYRO_POWER_DOWN);
+  check((model.peek(GYRO_REGISTER_CTRL_REG1) & 0x0F) == 0x00,
+        "power-down: PD clear");
+  delay(500);
+  gyro.setPowerMode(GYRO_POWER_NORMAL);
+  wake = micros();
+  delay(300);
+  size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE, times);
+  bool clean = (count > 0) && (count < 10);
+  for (size_t i = 0; i < count; i++) {
+    clean = clean && (abs(samples[i].z - 5714) < 3) &&
+            (times[i] - wake >= L3GD20_POWERDOWN_WAKE_US);
+  }
+  printf("  %u of %u FIFO samples kept\n", (unsigned)count,
+         (unsigned)(300000 / gyro.getSamplePeriod()));
+  check(clean, "settling samples dropped from the FIFO");
+  check(!gyro.isSettling(), "settled");
+
+  /* An entry left from before a sleep is not returned after it */
+  gyro.readFifo(samples, L3GD20_FIFO_SIZE);
+  delay(11);
+  model.update();
+  model.setSignal(0, 0, -50.0F);
+  gyro.setPowerMode(GYRO_POWER_SLEEP);
+  delay(100);
+  gyro.setPowerMode(GYRO_POWER_NORMAL);
+  wake = micros();
+  delay(50);
+  count = gyro.readFifo(samples, L3GD20_FIFO_SIZE, times);
+  clean = count > 0;
+  for (size_t i = 0; i < count; i++) {
+    clean = clean && (abs(samples[i].z + 5714) < 3) &&
+            (times[i] - wake >= L3GD20_SLEEP_WAKE_US);
+  }
+  check(clean, "FIFO emptied on wake");
+  model.setSignal(0, 0, 50.0F);
+  gyro.enableFifo(GYRO_FIFO_BYPASS);
+
+  /* Passing through sleep doesn't shorten the wake from power-down */
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  gyro.setPowerMode(GYRO_POWER_DOWN);
+  delay(100);
+  gyro.setPowerMode(GYRO_POWER_SLEEP);
+  delay(1);
+  gyro.setPowerMode(GYRO_POWER_NORMAL);
+  wake = micros();
+  got = false;
+  for (uint16_t i = 0; (i < 400) && !got; i++) {
+    delay(1);
+    got = gyro.getEvent(&event);
+  }
+  check(got && (gyro.timestamp - wake >= L3GD20_POWERDOWN_WAKE_US),
+        "power-down latency kept through sleep");
+
+  /* A 32 sample batch at 760 Hz every 2 s, powered down in between */
+  gyro.setDataRate(GYRO_DATARATE_760HZ);
+  uint64_t before[3];
+  memcpy(before, model.modeNs, sizeof(before));
+  check(gyro.startDutyCycle(2000, 32, GYRO_POWER_DOWN), "duty cycle started");
+  uint32_t start = micros();
+  uint32_t batches = 0;
+  uint32_t last = 0;
+  bool valid = true;
+  while (micros() - start < 10000000) {
+    SimClock::advance((uint64_t)gyro.getDutyCycleDelay() * 1000 + 1000);
+    count = gyro.pollDutyCycle(samples, L3GD20_FIFO_SIZE, times);
+    if (count == 0) {
+      continue;
+    }
+    batches++;
+    valid = valid && (count == 32) &&
+            ((batches == 1) || (times[0] - last > 1900000));
+    for (size_t i = 0; i < count; i++) {
+      valid = valid && (abs(samples[i].z - 5714) < 3);
+    }
+    last = times[0];
+  }
+  gyro.stopDutyCycle();
+  uint64_t spent[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    spent[i] = model.modeNs[i] - before[i];
+  }
+  float current = averageCurrent(spent);
+  printf("  %u batches, %.2f mA average against 6.1 mA always on\n",
+         (unsigned)batches, current);
+  check(batches == 5, "one batch every 2 s");
+  check(valid, "full batches of settled samples");
+  check(current < 1.5F, "average current below a quarter");
+  check((gyro.getPowerMode() == GYRO_POWER_NORMAL) &&
+            ((model.peek(GYRO_REGISTER_CTRL_REG1) & 0x0F) == 0x0F),
+        "stopped in normal mode");
+}
+
+static void scenarioL3GD20H(void) {
+  printf("L3GD20H rates and FIFO modes\n");
+  L3GD20Model h(SIM_L3GD20H);
+  L3GD20Model original(SIM_L3GD20);
+  Adafruit_L3GD20_Unified gyro;
+  gyroRawData_t samples[L3GD20_FIFO_SIZE];
+  uint32_t times[L3GD20_FIFO_SIZE];
+  sensors_event_t event;
+  sensor_t sensor;
+
+  setup(Wire, h);
+  h.setSignal(0, 0, 50.0F);
+  gyro.setDataRate(GYRO_DATARATE_800HZ);
+  uint32_t transactions = Wire.stats.transactions;
+  check(gyro.begin() && (gyro.getVariant() == GYRO_VARIANT_L3GD20H),
+        "variant detected");
+  uint32_t beginH = Wire.stats.transactions - transactions;
+  gyro.getSensor(&sensor);
+  check(strcmp(sensor.name, "L3GD20H") == 0, "reported as L3GD20H");
+  check(gyro.getSamplePeriod() == 1250, "800 Hz period");
+
+  gyro.enableFifo(GYRO_FIFO_DYNAMIC_STREAM);
+  check(h.peek(GYRO_REGISTER_FIFO_CTRL_REG) == GYRO_FIFO_DYNAMIC_STREAM,
+        "dynamic stream mode");
+  uint32_t generated = h.samplesGenerated;
+  uint32_t start = micros();
+  size_t total = 0;
+  bool spaced = true;
+  while (micros() - start < 1000000) {
+    delay(20);
+    size_t count = gyro.readFifo(samples, L3GD20_FIFO_SIZE, times);
+    for (size_t i = 1; i < count; i++) {
+      spaced = spaced && (abs((int32_t)(times[i] - times[i - 1]) - 1250) < 5);
+    }
+    total += count;
+  }
+  printf("  %u samples in 1 s\n", (unsigned)total);
+  check((h.samplesGenerated - generated > 795) && (total > 795) &&
+            (h.samplesLost == 0),
+        "every sample at 800 Hz");
+  check(spaced, "timestamps 1250 us apart");
+  gyro.enableFifo(GYRO_FIFO_BYPASS);
+
+  /* LOW_ODR takes the rate down to 12.5 Hz */
+  gyro.setDataRate(GYRO_DATARATE_12_5HZ);
+  check(((h.peek(GYRO_REGISTER_LOW_ODR) & 0x01) == 1) &&
+            ((h.peek(GYRO_REGISTER_CTRL_REG1) >> 6) == 0),
+        "Low_ODR set");
+  check((h.samplePeriodNs() == 80000000) &&
+            (gyro.getSamplePeriod() == 80000),
+        "12.5 Hz period");
+  h.update();
+  generated = h.samplesGenerated;
+  delay(1000);
+  h.update();
+  check(h.samplesGenerated - generated == 12 ||
+            h.samplesGenerated - generated == 13,
+        "12.5 samples per second");
+  check(gyro.getEvent(&event) &&
+            near(event.gyro.z, 50 * SENSORS_DPS_TO_RADS, 0.001F),
+        "getEvent() at 12.5 Hz");
+  gyro.setDataRate(GYRO_DATARATE_200HZ);
+  check((h.peek(GYRO_REGISTER_LOW_ODR) & 0x01) == 0, "Low_ODR cleared");
+
+  /* The original part falls back and never touches LOW_ODR */
+  setup(Wire, original);
+  gyro = Adafruit_L3GD20_Unified();
+  gyro.setDataRate(GYRO_DATARATE_25HZ);
+  transactions = Wire.stats.transactions;
+  check(gyro.begin() && (gyro.getVariant() == GYRO_VARIANT_L3GD20) &&
+            (gyro.getDataRate() == GYRO_DATARATE_95HZ),
+        "L3GD20 runs at 95 Hz instead");
+  check(Wire.stats.transactions - transactions == beginH - 1,
+        "no LOW_ODR write");
+  gyro.enableFifo(GYRO_FIFO_DYNAMIC_STREAM);
+  check(original.peek(GYRO_REGISTER_FIFO_CTRL_REG) == GYRO_FIFO_STREAM,
+        "dynamic stream falls back to stream");
+}
+
+/* Everything the capture scenario's code path returned */
+typedef struct {
+  gyroRawData_t samples[200];
+  uint32_t times[200];
+  uint16_t ranges[200];
+  size_t count;
+  uint8_t failures;
+} captureResult_t;
+
+/* Auto-ranging getEvent() through a NACK storm, then FIFO batches */
+static void captureWorkload(Adafruit_L3GD20_Unified &gyro,
+                            captureResult_t *out) {
+  sensors_event_t event;
+
+  out->count = 0;
+  out->failures = 0;
+  gyro.enableAutoRange(true);
+  gyro.begin(GYRO_RANGE_250DPS);
+  delay(20);
+  for (uint8_t i = 0; i < 60; i++) {
+    if (i == 30) {
+      Wire.nackNext(3);
+    }
+    if (gyro.getEvent(&event)) {
+      out->samples[out->count] = gyro.raw;
+      out->times[out->count] = gyro.timestamp;
+      out->ranges[out->count++] = (uint16_t)gyro.getRange();
+    } else {
+      out->failures++;
+    }
+    delayMicroseconds(gyro.getSamplePeriod());
+  }
+
+  gyro.enableFifo(GYRO_FIFO_STREAM);
+  for (uint8_t i = 0; i < 4; i++) {
+    delay(25);
+    size_t n = gyro.readFifo(&out->samples[out->count], L3GD20_FIFO_SIZE,
+                             &out->times[out->count]);
+    for (size_t j = 0; j < n; j++) {
+      out->ranges[out->count++] = (uint16_t)gyro.getRange();
+    }
+  }
+}
+
+static void scenarioCapture(void) {
+  printf("bus capture and replay\n");
+  L3GD20Model model;
+  L3GD20Capture capture;
+  static captureResult_t live, replayed;
+  uint64_t step = 200000000ULL;
+
+  setup(Wire, model);
+  model.setSignal(stepSignal, &step);
+  Adafruit_L3GD20_Unified gyro;
+  gyro.setBusCapture(L3GD20Capture::record, &capture);
+  captureWorkload(gyro, &live);
+  gyroBusRecord_t record;
+  uint32_t records = 0;
+  size_t used;
+  for (size_t at = 0; (used = l3gd20ParseCapture(capture.data + at,
+                                                  capture.size - at, &record));
+       at += used) {
+    records++;
+  }
+  printf("  %u samples, %u records in %u bytes\n", (unsigned)live.count,
+         (unsigned)records, (unsigned)capture.size);
+  check((live.failures == 0) && (live.ranges[live.count - 1] == 500),
+        "live run rides out the NACKs and escalates");
+
+  /* Same code with no sensor on the bus */
+  Wire = TwoWire();
+  SimClock::reset();
+  L3GD20Replay replay(capture.data, capture.size);
+  Adafruit_L3GD20_Unified replica;
+  replica.setBusReplay(L3GD20Replay::replay, &replay);
+  captureWorkload(replica, &replayed);
+  bool same = (replayed.count == live.count) &&
+              (replayed.failures == live.failures);
+  for (size_t i = 0; same && (i < live.count); i++) {
+    same = (memcmp(&replayed.samples[i], &live.samples[i],
+                   sizeof(gyroRawData_t)) == 0) &&
+           (replayed.times[i] == live.times[i]) &&
+           (replayed.ranges[i] == live.ranges[i]);
+  }
+  check(same, "replay returns the same samples, times and ranges");
+  check((replay.mismatches == 0) && replay.finished() &&
+            (replay.records == records),
+        "driver makes the captured transactions in order");
+  check(Wire.stats.transactions == 0, "no bus traffic during replay");
+
+  /* A capture from a different code path is caught */
+  replay.rewind();
+  SimClock::reset();
+  Adafruit_L3GD20_Unified other;
+  other.setBusReplay(L3GD20Replay::replay, &replay);
+  other.begin(GYRO_RANGE_2000DPS);
+  check(replay.mismatches > 0, "diverging driver reported");
+}
+
+int main(void) {
+  scenarioIdentify();
+  scenarioGetEvent();
+  scenarioAutoRange();
+  scenarioFifo();
+  scenarioBusErrors();
+  scenarioGroup();
+  scenarioSpi();
+  scenarioTransports();
+  scenarioShadow();
+  scenarioTimestamps();
+  scenarioStatusRead();
+  scenarioBias();
+  scenarioAttitude();
+  scenarioHighPass();
+  scenarioMotion();
+  scenarioStream();
+  scenarioConvert();
+  scenarioAxes();
+  scenarioPowerModes();
+  scenarioL3GD20H();
+  scenarioCapture();
+
+  printf("%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}